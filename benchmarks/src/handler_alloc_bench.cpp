@@ -0,0 +1,183 @@
+// Handler allocation benchmark: a keep-alive client sends requests one at a time
+// to the in-process proxy, the global operator new calls are counted per request
+// (the client itself doesn't allocate while measuring).
+//  - local: the stats endpoint, the client read/write chain only
+//  - proxied: /api/v3/ping forwarded to the upstream (requires access to api.binance.com,
+//    skipped otherwise), the upstream connect/write/read chain as well
+// "handler fallbacks" are the handler operations that didn't fit the sessions'
+// handler memory and were allocated on the heap.
+//
+// usage: handler_alloc_bench [requests per step]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <asio.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "server.h"
+
+using asio::ip::tcp;
+
+namespace
+{
+    std::atomic<uint64_t> allocations{0};
+}
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    struct Result
+    {
+        size_t requests = 0; // answered with 200 OK
+        uint64_t allocations = 0;
+        uint64_t handler_fallbacks = 0;
+    };
+
+    class Client
+    {
+    public:
+        explicit Client(const tcp::endpoint& endpoint) : socket_(io_)
+        {
+            socket_.connect(endpoint);
+            socket_.set_option(tcp::no_delay(true));
+        }
+
+        // the whole response: headers and Content-Length bytes of body, false on failure
+        bool request(const std::string& request)
+        {
+            asio::error_code ec;
+            asio::write(socket_, asio::buffer(request), ec);
+
+            size_t received = 0, expected = 0;
+            while (!ec && ((expected == 0) || (received < expected)))
+            {
+                received += socket_.read_some(asio::buffer(buffer_.data() + received, buffer_.size() - received), ec);
+
+                const std::string_view data(buffer_.data(), received);
+                const size_t end = data.find("\r\n\r\n");
+                const size_t pos = data.find("Content-Length: ");
+                if ((expected == 0) && (end != std::string_view::npos) && (pos != std::string_view::npos))
+                    expected = end + 4 + std::strtoull(data.data() + pos + 16, nullptr, 10);
+            }
+            return !ec && (std::string_view(buffer_.data(), received).rfind("HTTP/1.1 200", 0) == 0);
+        }
+
+    private:
+        asio::io_context io_;
+        tcp::socket socket_;
+        std::array<char, 16 * 1024> buffer_;
+    };
+
+    Result run_step(Client& client, const char* target, size_t requests)
+    {
+        const std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", target);
+
+        // warm-up: upstream connection established, buffers grown, recycled blocks available
+        for (size_t i = 0; i < 16; i++)
+            if (!client.request(request))
+                return {};
+
+        Result result;
+        const uint64_t allocations_before = allocations.load();
+        const uint64_t fallbacks_before = gl_stats.handler_memory_fallbacks.load();
+        for (size_t i = 0; i < requests; i++)
+            if (client.request(request))
+                result.requests++;
+        result.allocations = allocations.load() - allocations_before;
+        result.handler_fallbacks = gl_stats.handler_memory_fallbacks.load() - fallbacks_before;
+        return result;
+    }
+
+    void print(const char* name, const Result& result)
+    {
+        if (result.requests == 0)
+        {
+            std::cout << fmt::format("  {:<8} skipped (no successful response)", name) << std::endl;
+            return;
+        }
+
+        const double requests = static_cast<double>(result.requests);
+        std::cout << fmt::format("  {:<8} requests: {:>6}  operator new/request: {:>6.2f}  handler fallbacks/request: {:>5.2f}",
+                                 name, result.requests, static_cast<double>(result.allocations) / requests,
+                                 static_cast<double>(result.handler_fallbacks) / requests)
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t requests = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    const unsigned short port = 18390;
+
+    gl_logger = spdlog::default_logger();
+    gl_logger->set_level(spdlog::level::off);
+
+    ServerOptions server_options;
+    server_options.threads = 1;
+    UpstreamPool::Options pool_options;
+    pool_options.min_size = 1;
+
+    Server server(port, ServerRunningMode::Persistent, server_options, pool_options);
+    std::thread server_thread([&server]()
+                              { server.run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::cout << fmt::format("1 keep-alive client, 1 server thread, {} sequential requests per step", requests)
+              << std::endl;
+    {
+        Client client(tcp::endpoint(asio::ip::make_address("127.0.0.1"), port));
+        print("local", run_step(client, stats_target, requests));
+        print("proxied", run_step(client, "/api/v3/ping", requests));
+    }
+
+    std::raise(SIGINT); // graceful server shutdown
+    server_thread.join();
+    return 0;
+}
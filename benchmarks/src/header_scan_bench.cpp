@@ -0,0 +1,134 @@
+// Header scanning benchmark on typical Binance client request heads:
+//  - framing: the end of the head, the byte by byte search of async_read_until
+//    vs find_header_end with each instruction set of the build
+//  - parsing: async_read_until's search followed by the parser (two passes)
+//    vs the parser alone (a single pass of the header scanner), per instruction set
+// The checksum in brackets keeps the results in use.
+//
+// usage: header_scan_bench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "utils/header-scanner.h"
+#include "utils/http-request-parser.h"
+
+namespace
+{
+    // asio::async_read_until's delimiter search (a partial match is extended byte by byte)
+    size_t read_until_search(const std::string& head)
+    {
+        const std::string_view delimiter = "\r\n\r\n";
+        const auto end = std::search(head.begin(), head.end(), delimiter.begin(), delimiter.end());
+        return (end == head.end()) ? std::string_view::npos : static_cast<size_t>(end - head.begin()) + 4;
+    }
+
+    template <typename Scan>
+    void run(const char* name, const std::string& head, size_t iterations, Scan scan)
+    {
+        size_t checksum = 0;
+        // read through a volatile pointer, the loop invariant results aren't hoisted
+        const std::string* volatile input = &head;
+
+        const auto started_at = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+            checksum += scan(*input);
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started_at);
+
+        std::cout << fmt::format("  {:<26} {:>8.1f} ns/request  [{}]", name,
+                                 elapsed.count() / static_cast<double>(iterations), checksum % 10)
+                  << std::endl;
+    }
+
+    template <ScanIsa isa>
+    void run_isa(const std::string& head, size_t iterations)
+    {
+        run(fmt::format("framing, {}", scan_isa_name(isa)).c_str(), head, iterations,
+            [](const std::string& head)
+            { return find_header_end<isa>(head.data(), 0, head.size()); });
+
+        run(fmt::format("parsing, {}", scan_isa_name(isa)).c_str(), head, iterations,
+            [](const std::string& head)
+            {
+                HttpRequestParser parser;
+                parser.parse<isa>(head);
+                return parser.size() + parser.header_count();
+            });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    const std::pair<const char*, std::string> heads[] = {
+        {"curl ping",
+         "GET /api/v3/ping HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "User-Agent: curl/8.5.0\r\n"
+         "Accept: */*\r\n"
+         "\r\n"},
+        {"python-binance depth",
+         "GET /api/v3/depth?symbol=BTCUSDT&limit=100 HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+         "Chrome/56.0.2924.87 Safari/537.36\r\n"
+         "Accept-Encoding: gzip, deflate\r\n"
+         "Accept: application/json\r\n"
+         "Connection: keep-alive\r\n"
+         "Content-Type: application/json\r\n"
+         "X-MBX-APIKEY: vmPUZE6mv9SD5VNHk4HlWFsOr6aKE2zvsw0MuIgwCIPy6utIco14y7Ju91duEh8A\r\n"
+         "\r\n"},
+        {"browser klines",
+         "GET /api/v3/klines?symbol=ETHUSDT&interval=1m&limit=500 HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "Connection: keep-alive\r\n"
+         "sec-ch-ua: \"Chromium\";v=\"130\", \"Google Chrome\";v=\"130\", \"Not?A_Brand\";v=\"99\"\r\n"
+         "sec-ch-ua-mobile: ?0\r\n"
+         "sec-ch-ua-platform: \"Windows\"\r\n"
+         "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) "
+         "Chrome/130.0.0.0 Safari/537.36\r\n"
+         "Accept: application/json, text/plain, */*\r\n"
+         "Origin: http://localhost:3000\r\n"
+         "Sec-Fetch-Site: same-site\r\n"
+         "Sec-Fetch-Mode: cors\r\n"
+         "Sec-Fetch-Dest: empty\r\n"
+         "Referer: http://localhost:3000/\r\n"
+         "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+         "Accept-Language: en-US,en;q=0.9\r\n"
+         "\r\n"}};
+
+    std::cout << fmt::format("{} iterations per step, native instruction set: {}", iterations,
+                             scan_isa_name(native_scan_isa))
+              << std::endl;
+    for (const auto& [name, head] : heads)
+    {
+        std::cout << fmt::format("{} ({} B)", name, head.size()) << std::endl;
+
+        run("framing, read_until", head, iterations, read_until_search);
+        run_isa<ScanIsa::Scalar>(head, iterations);
+#ifdef MB_SCAN_SSE2
+        run_isa<ScanIsa::Sse2>(head, iterations);
+#endif
+#ifdef __AVX2__
+        run_isa<ScanIsa::Avx2>(head, iterations);
+#endif
+
+        run(fmt::format("parsing, read_until + {}", scan_isa_name(native_scan_isa)).c_str(), head, iterations,
+            [](const std::string& head)
+            {
+                const size_t end = read_until_search(head);
+                HttpRequestParser parser;
+                parser.parse(std::string_view(head).substr(0, end));
+                return parser.size() + parser.header_count();
+            });
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+// I/O backend benchmark: keep-alive clients request the locally served
+// stats endpoint of the in-process proxy, one request at a time, so that
+// each request costs the server a read, a write and a reactor wait.
+// Reported: requests/s, system calls (raw_syscalls:sys_enter tracepoint)
+// and context switches per request of the server threads, "n/a" where
+// perf events aren't permitted (kernel.perf_event_paranoid, tracefs access).
+// The backend is fixed at build time, the comparison is made by running the
+// benchmark of an epoll build and of an io_uring one (-DMB_IO_URING=ON) on
+// the same machine.
+//
+// usage: io_backend_bench [seconds per engine] [server threads]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <asio.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "server.h"
+
+using asio::ip::tcp;
+
+namespace
+{
+    constexpr size_t clients = 16;
+
+    struct Result
+    {
+        double requests_per_second = 0;
+        uint64_t total_requests = 0; // the whole server run
+        std::optional<uint64_t> syscalls;
+        std::optional<uint64_t> context_switches;
+    };
+
+#ifdef __linux__
+    // id of the system call entry tracepoint, 0 if tracefs isn't readable
+    uint64_t sys_enter_tracepoint()
+    {
+        for (const char* path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"})
+        {
+            std::ifstream file(path);
+            uint64_t id = 0;
+            if (file >> id)
+                return id;
+        }
+        return 0;
+    }
+#endif
+
+    enum class Event
+    {
+        Syscalls,
+        ContextSwitches
+    };
+
+    // perf event of the calling thread and the threads it creates afterwards,
+    // read once they have all exited
+    class PerfCounter
+    {
+    public:
+        explicit PerfCounter(Event event)
+        {
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            if (event == Event::Syscalls)
+            {
+                attr.type = PERF_TYPE_TRACEPOINT;
+                attr.config = sys_enter_tracepoint();
+                if (attr.config == 0)
+                    return;
+            }
+            else
+            {
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            }
+            attr.size = sizeof(attr);
+            attr.inherit = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+            (void)event;
+#endif
+        }
+
+        ~PerfCounter()
+        {
+#ifdef __linux__
+            if (fd_ >= 0)
+                close(fd_);
+#endif
+        }
+
+        std::optional<uint64_t> read() const
+        {
+#ifdef __linux__
+            uint64_t count = 0;
+            if ((fd_ >= 0) && (::read(fd_, &count, sizeof(count)) == sizeof(count)))
+                return count;
+#endif
+            return std::nullopt;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    // one request at a time on a keep-alive connection
+    void run_client(const tcp::endpoint& endpoint, const std::atomic<bool>& stopping)
+    {
+        asio::io_context io;
+        tcp::socket socket(io);
+        asio::error_code ec;
+        socket.connect(endpoint, ec);
+        if (ec)
+            return;
+        socket.set_option(tcp::no_delay(true));
+
+        const std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", stats_target);
+        std::array<char, 16 * 1024> buffer;
+
+        while (!stopping && !ec)
+        {
+            asio::write(socket, asio::buffer(request), ec);
+
+            // the whole response: headers and Content-Length bytes of body
+            size_t received = 0, expected = 0;
+            while (!ec && ((expected == 0) || (received < expected)))
+            {
+                received += socket.read_some(asio::buffer(buffer.data() + received, buffer.size() - received), ec);
+
+                const std::string_view data(buffer.data(), received);
+                const size_t end = data.find("\r\n\r\n");
+                const size_t pos = data.find("Content-Length: ");
+                if ((expected == 0) && (end != std::string_view::npos) && (pos != std::string_view::npos))
+                    expected = end + 4 + std::strtoull(data.data() + pos + 16, nullptr, 10);
+            }
+        }
+    }
+
+    Result run_engine(unsigned short port, EngineMode engine, size_t server_threads, std::chrono::seconds duration)
+    {
+        ServerOptions server_options;
+        server_options.threads = server_threads;
+        server_options.engine = engine;
+        UpstreamPool::Options pool_options;
+        pool_options.min_size = 0;
+
+        Result result;
+        const uint64_t requests_at_start = gl_stats.client_requests.load();
+        Server server(port, ServerRunningMode::Persistent, server_options, pool_options);
+        std::thread server_thread([&server, &result]()
+                                  {
+                                      PerfCounter syscalls(Event::Syscalls);
+                                      PerfCounter context_switches(Event::ContextSwitches);
+
+                                      server.run();
+
+                                      result.syscalls = syscalls.read();
+                                      result.context_switches = context_switches.read();
+                                  });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        const tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+        std::atomic<bool> stopping{false};
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < clients; i++)
+            threads.emplace_back([&]()
+                                 { run_client(endpoint, stopping); });
+
+        // warm-up, then measure
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const uint64_t requests_before = gl_stats.client_requests.load();
+        const auto started_at = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(duration);
+        const uint64_t count = gl_stats.client_requests.load() - requests_before;
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at);
+        result.requests_per_second = static_cast<double>(count) / elapsed.count();
+
+        stopping = true;
+        for (auto& thread : threads)
+            thread.join();
+
+        std::raise(SIGINT); // graceful server shutdown
+        server_thread.join();
+        result.total_requests = gl_stats.client_requests.load() - requests_at_start;
+
+        return result;
+    }
+
+    std::string per_request(const std::optional<uint64_t>& count, uint64_t requests)
+    {
+        if (!count)
+            return "   n/a";
+        return fmt::format("{:>6.2f}",
+                           static_cast<double>(*count) / static_cast<double>(std::max<uint64_t>(requests, 1)));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::chrono::seconds duration((argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 3);
+    const size_t server_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2;
+
+    gl_logger = spdlog::default_logger();
+    gl_logger->set_level(spdlog::level::off);
+
+    std::cout << fmt::format("I/O backend: {}, {} keep-alive clients, {} server threads, {} s per engine",
+                             io_backend, clients, server_threads, duration.count())
+              << std::endl;
+
+    const std::pair<const char*, EngineMode> engines[] = {{"shared", EngineMode::Shared},
+                                                          {"per-core", EngineMode::PerCore}};
+
+    unsigned short port = 18290;
+    for (const auto& [name, engine] : engines)
+    {
+        const Result result = run_engine(port++, engine, server_threads, duration);
+
+        // the counts cover the whole server run, warm-up and shutdown included
+        std::cout << fmt::format("  {:<9} {:>9.0f} requests/s  syscalls/request: {}  context switches/request: {}",
+                                 name, result.requests_per_second, per_request(result.syscalls, result.total_requests),
+                                 per_request(result.context_switches, result.total_requests))
+                  << std::endl;
+    }
+    return 0;
+}
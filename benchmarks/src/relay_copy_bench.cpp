@@ -0,0 +1,120 @@
+// Response relay copy benchmark (buffered relay mode):
+// the previous stringstream based path vs the BufferChain path.
+// Upstream reads are simulated by copying from a payload in 4 KB pieces
+// (not counted as relay copies), the client write by walking the buffers.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "utils/buffer-chain.h"
+
+namespace
+{
+    constexpr size_t read_size = 4096;
+
+    struct Result
+    {
+        size_t bytes_copied = 0;
+        size_t checksum = 0;
+    };
+
+    size_t touch(const char* data, size_t size)
+    {
+        size_t sum = 0;
+        for (size_t i = 0; i < size; i += 64)
+            sum += static_cast<unsigned char>(data[i]);
+        return sum;
+    }
+
+    // read into buffer_ -> stringstream -> str() -> HTTPSession::response_ -> async_write
+    Result stringstream_relay(const std::string& payload)
+    {
+        Result result;
+        std::array<char, read_size> buffer;
+        std::stringstream response;
+
+        for (size_t pos = 0; pos < payload.size(); pos += read_size)
+        {
+            const size_t n = std::min(read_size, payload.size() - pos);
+            std::memcpy(buffer.data(), payload.data() + pos, n); // socket read
+
+            response.write(buffer.data(), static_cast<std::streamsize>(n));
+            result.bytes_copied += n;
+        }
+
+        std::string resp(response.str());
+        result.bytes_copied += resp.size();
+
+        std::string session_response = std::move(resp);
+        result.checksum = touch(session_response.data(), session_response.size());
+        return result;
+    }
+
+    // read into the chain's tail block -> gathered async_write
+    Result buffer_chain_relay(const std::string& payload)
+    {
+        Result result;
+        auto chain = std::make_shared<BufferChain>();
+
+        for (size_t pos = 0; pos < payload.size();)
+        {
+            auto space = chain->prepare();
+            const size_t n = std::min({read_size, space.size(), payload.size() - pos});
+            std::memcpy(space.data(), payload.data() + pos, n); // socket read
+            chain->commit(n);
+            pos += n;
+        }
+
+        SharedBufferChain response = chain;
+        for (const auto& buffer : response->buffers())
+            result.checksum += touch(static_cast<const char*>(buffer.data()), buffer.size());
+        return result;
+    }
+
+    template <typename Relay>
+    void run(const char* name, const std::string& payload, size_t iterations, Relay relay)
+    {
+        Result last;
+        size_t checksum = 0;
+
+        const auto started_at = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            last = relay(payload);
+            checksum += last.checksum;
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started_at);
+
+        std::cout << fmt::format("  {:<14} bytes copied/request: {:>10}  ({:.1f}x payload)  {:>10.1f} us/request  [{}]",
+                                 name, last.bytes_copied,
+                                 static_cast<double>(last.bytes_copied) / static_cast<double>(payload.size()),
+                                 elapsed.count() / static_cast<double>(iterations), checksum % 10)
+                  << std::endl;
+    }
+}
+
+int main()
+{
+    const std::pair<const char*, size_t> payloads[] = {
+        {"ticker/price?symbol (~100 B)", 100},
+        {"depth?limit=100 (~6 KB)", 6 * 1024},
+        {"ticker/24hr (~800 KB)", 800 * 1024},
+        {"exchangeInfo (~3 MB)", 3 * 1024 * 1024}};
+
+    for (const auto& [name, size] : payloads)
+    {
+        const std::string payload(size, '{');
+        const size_t iterations = std::max<size_t>(20, (64 * 1024 * 1024) / size);
+
+        std::cout << name << ", " << iterations << " requests" << std::endl;
+        run("stringstream", payload, iterations, stringstream_relay);
+        run("buffer-chain", payload, iterations, buffer_chain_relay);
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Request parsing benchmark: the previous istringstream based parse_request
+// (fed a copy of the received bytes) vs the in-place HttpRequestParser.
+//  - in-place: the views into the receive buffer only
+//  - to request: the views and the owned HttpRequest an exchange keeps
+//  - 16 B pieces: the head received in pieces, parsed incrementally
+//  - lookups: Connection, User-Agent and X-MBX-APIKEY of a parsed request, the previous
+//    case-insensitive search of the std::map vs the well-known header ids
+// The checksum in brackets keeps the results in use.
+//
+// usage: request_parser_bench [iterations]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "utils/http-request-parser.h"
+
+namespace
+{
+    struct LegacyRequest
+    {
+        std::string method;
+        std::string target;
+        std::string version;
+        std::map<std::string, std::string> headers;
+        std::string body;
+    };
+
+    // parse_request before the in-place parser
+    LegacyRequest istringstream_parse(const std::string& raw)
+    {
+        LegacyRequest req;
+        std::istringstream iss(raw);
+        std::string line;
+
+        if (!std::getline(iss, line))
+            return req;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        {
+            std::istringstream rl(line);
+            rl >> req.method >> req.target >> req.version;
+        }
+
+        while (std::getline(iss, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                break;
+            auto pos = line.find(':');
+            if (pos != std::string::npos)
+            {
+                std::string name = line.substr(0, pos);
+                std::string value = line.substr(pos + 1);
+                while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                    value.erase(value.begin());
+                req.headers[name] = value;
+            }
+        }
+
+        std::string body;
+        std::getline(iss, body, '\0');
+        req.body = body;
+        return req;
+    }
+
+    // find_header over the previous std::map headers
+    const std::string* legacy_find(const LegacyRequest& request, std::string_view name)
+    {
+        for (const auto& [key, value] : request.headers)
+            if (iequals(key, name))
+                return &value;
+        return nullptr;
+    }
+
+    template <typename Input, typename Parse>
+    double run(const char* name, const Input& head, size_t iterations, Parse parse)
+    {
+        size_t checksum = 0;
+        // read through a volatile pointer, the loop invariant results aren't hoisted
+        const Input* volatile input = &head;
+
+        const auto started_at = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+            checksum += parse(*input);
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started_at);
+
+        const double per_request = elapsed.count() / static_cast<double>(iterations);
+        std::cout << fmt::format("  {:<14} {:>8.1f} ns/request  [{}]", name, per_request, checksum % 10) << std::endl;
+        return per_request;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    const std::pair<const char*, std::string> heads[] = {
+        {"curl ping",
+         "GET /api/v3/ping HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "User-Agent: curl/8.5.0\r\n"
+         "Accept: */*\r\n"
+         "\r\n"},
+        {"python-binance depth",
+         "GET /api/v3/depth?symbol=BTCUSDT&limit=100 HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+         "Chrome/56.0.2924.87 Safari/537.36\r\n"
+         "Accept-Encoding: gzip, deflate\r\n"
+         "Accept: application/json\r\n"
+         "Connection: keep-alive\r\n"
+         "Content-Type: application/json\r\n"
+         "X-MBX-APIKEY: vmPUZE6mv9SD5VNHk4HlWFsOr6aKE2zvsw0MuIgwCIPy6utIco14y7Ju91duEh8A\r\n"
+         "\r\n"},
+        {"signed account",
+         "GET /api/v3/account?omitZeroBalances=true&recvWindow=5000&timestamp=1729170000000"
+         "&signature=c8db56825ae71d6d79447849e617115f4a920fa2acdcab2b053c4b2838bd6b71 HTTP/1.1\r\n"
+         "Host: localhost:8080\r\n"
+         "User-Agent: binance-connector-java/3.0.0\r\n"
+         "Accept-Encoding: gzip\r\n"
+         "Connection: Keep-Alive\r\n"
+         "X-MBX-APIKEY: vmPUZE6mv9SD5VNHk4HlWFsOr6aKE2zvsw0MuIgwCIPy6utIco14y7Ju91duEh8A\r\n"
+         "\r\n"}};
+
+    std::cout << fmt::format("{} iterations per parser", iterations) << std::endl;
+    for (const auto& [name, head] : heads)
+    {
+        std::cout << fmt::format("{} ({} B)", name, head.size()) << std::endl;
+
+        const double previous = run("istringstream", head, iterations,
+                                    [](const std::string& head)
+                                    {
+                                        const std::string raw_request(head); // copied out of the streambuf
+                                        return istringstream_parse(raw_request).headers.size();
+                                    });
+
+        const double in_place = run("in-place", head, iterations,
+                                    [](const std::string& head)
+                                    {
+                                        HttpRequestParser parser;
+                                        parser.parse(head);
+                                        return parser.header_count() + parser.target().size();
+                                    });
+
+        run("to request", head, iterations,
+            [](const std::string& head)
+            {
+                HttpRequestParser parser;
+                parser.parse(head);
+                return make_request(parser).headers.size();
+            });
+
+        run("16 B pieces", head, iterations,
+            [](const std::string& head)
+            {
+                HttpRequestParser parser;
+                for (size_t size = 16; parser.parse(std::string_view(head).substr(0, size)) ==
+                                       HttpRequestParser::Status::Incomplete;
+                     size += 16)
+                    ;
+                return parser.header_count();
+            });
+
+        std::cout << fmt::format("  in-place speed-up: {:.1f}x", previous / in_place) << std::endl;
+
+        run("map lookups", istringstream_parse(head), iterations,
+            [](const LegacyRequest& request)
+            {
+                size_t found = 0;
+                for (const char* name : {"Connection", "User-Agent", "X-MBX-APIKEY"})
+                    if (const std::string* value = legacy_find(request, name))
+                        found += value->size();
+                return found;
+            });
+
+        run("id lookups", parse_request(head), iterations,
+            [](const HttpRequest& request)
+            {
+                size_t found = 0;
+                for (HeaderId id : {HeaderId::Connection, HeaderId::UserAgent, HeaderId::XMbxApiKey})
+                    if (const auto value = request.headers.find(id))
+                        found += value->size();
+                return found;
+            });
+    }
+    return 0;
+}
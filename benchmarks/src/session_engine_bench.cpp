@@ -0,0 +1,283 @@
+// Session engine benchmark: keep-alive clients request the locally served
+// stats endpoint of the in-process proxy, once per client session engine
+// (callback, and coroutine when built with MB_COROUTINES).
+// Reported per request: heap allocations (global operator new, the clients
+// don't allocate while measuring), instructions retired by the server
+// threads (perf_event_open, "n/a" where perf events aren't permitted) and
+// latency percentiles.
+//
+// usage: session_engine_bench [seconds per engine] [server threads]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <asio.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "server.h"
+
+using asio::ip::tcp;
+
+namespace
+{
+    std::atomic<uint64_t> allocations{0};
+}
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    constexpr size_t clients = 8;
+
+    struct Result
+    {
+        uint64_t requests = 0;       // while measuring
+        uint64_t total_requests = 0; // the whole server run
+        uint64_t allocations = 0;
+        std::optional<uint64_t> instructions;
+        std::vector<double> latencies_ms;
+    };
+
+    // instructions retired by the calling thread and the threads it creates afterwards,
+    // read once they have all exited
+    class InstructionCounter
+    {
+    public:
+        InstructionCounter()
+        {
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+
+        ~InstructionCounter()
+        {
+#ifdef __linux__
+            if (fd_ >= 0)
+                close(fd_);
+#endif
+        }
+
+        std::optional<uint64_t> read() const
+        {
+#ifdef __linux__
+            uint64_t count = 0;
+            if ((fd_ >= 0) && (::read(fd_, &count, sizeof(count)) == sizeof(count)))
+                return count;
+#endif
+            return std::nullopt;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    // one request at a time on a keep-alive connection, nothing is allocated per request
+    void run_client(const tcp::endpoint& endpoint, const std::atomic<bool>& measuring,
+                    const std::atomic<bool>& stopping, Result& result, std::mutex& mutex)
+    {
+        asio::io_context io;
+        tcp::socket socket(io);
+        asio::error_code ec;
+        socket.connect(endpoint, ec);
+        if (ec)
+            return;
+        socket.set_option(tcp::no_delay(true));
+
+        const std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", stats_target);
+        std::array<char, 16 * 1024> buffer;
+        std::vector<double> latencies;
+        latencies.reserve(1 << 20);
+
+        while (!stopping)
+        {
+            const auto started_at = std::chrono::steady_clock::now();
+
+            asio::write(socket, asio::buffer(request), ec);
+
+            // the whole response: headers and Content-Length bytes of body
+            size_t received = 0, expected = 0;
+            while (!ec && ((expected == 0) || (received < expected)))
+            {
+                received += socket.read_some(asio::buffer(buffer.data() + received, buffer.size() - received), ec);
+
+                const std::string_view data(buffer.data(), received);
+                const size_t end = data.find("\r\n\r\n");
+                const size_t pos = data.find("Content-Length: ");
+                if ((expected == 0) && (end != std::string_view::npos) && (pos != std::string_view::npos))
+                    expected = end + 4 + std::strtoull(data.data() + pos + 16, nullptr, 10);
+            }
+            if (ec)
+                break;
+
+            if (measuring)
+                latencies.push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_at).count());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result.latencies_ms.insert(result.latencies_ms.end(), latencies.begin(), latencies.end());
+    }
+
+    Result run_engine(unsigned short port, SessionEngine engine, size_t server_threads, std::chrono::seconds duration)
+    {
+        ServerOptions server_options;
+        server_options.threads = server_threads;
+        server_options.session_engine = engine;
+        UpstreamPool::Options pool_options;
+        pool_options.min_size = 0;
+
+        Result result;
+        const uint64_t requests_at_start = gl_stats.client_requests.load();
+        Server server(port, ServerRunningMode::Persistent, server_options, pool_options);
+        std::thread server_thread([&server, &result]()
+                                  {
+                                      InstructionCounter counter;
+                                      server.run();
+                                      result.instructions = counter.read();
+                                  });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        const tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+        std::atomic<bool> measuring{false}, stopping{false};
+        std::mutex mutex;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < clients; i++)
+            threads.emplace_back([&]()
+                                 { run_client(endpoint, measuring, stopping, result, mutex); });
+
+        // warm-up: connections accepted, buffers grown
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const uint64_t requests_before = gl_stats.client_requests.load();
+        const uint64_t allocations_before = allocations.load();
+        measuring = true;
+
+        std::this_thread::sleep_for(duration);
+
+        measuring = false;
+        result.allocations = allocations.load() - allocations_before;
+        result.requests = gl_stats.client_requests.load() - requests_before;
+
+        stopping = true;
+        for (auto& thread : threads)
+            thread.join();
+
+        std::raise(SIGINT); // graceful server shutdown
+        server_thread.join();
+        result.total_requests = gl_stats.client_requests.load() - requests_at_start;
+
+        std::sort(result.latencies_ms.begin(), result.latencies_ms.end());
+        return result;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::chrono::seconds duration((argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 3);
+    const size_t server_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2;
+
+    gl_logger = spdlog::default_logger();
+    gl_logger->set_level(spdlog::level::off);
+
+    std::cout << fmt::format("{} keep-alive clients, {} server threads, {} s per engine", clients, server_threads,
+                             duration.count())
+              << std::endl;
+
+    std::vector<std::pair<std::string, SessionEngine>> engines = {{"callback", SessionEngine::Callback}};
+#ifdef MB_COROUTINES
+    engines.emplace_back("coroutine", SessionEngine::Coroutine);
+#else
+    std::cout << "  (coroutine engine not built, configure with -DMB_COROUTINES=ON)" << std::endl;
+#endif
+
+    unsigned short port = 18190;
+    for (const auto& [name, engine] : engines)
+    {
+        const Result result = run_engine(port++, engine, server_threads, duration);
+        const double requests = static_cast<double>(std::max<uint64_t>(result.requests, 1));
+
+        // the instruction count covers the whole server run, warm-up and shutdown included
+        const std::string instructions =
+            result.instructions
+                ? fmt::format("{:>8.0f}", static_cast<double>(*result.instructions) /
+                                              static_cast<double>(std::max<uint64_t>(result.total_requests, 1)))
+                : std::string("     n/a");
+
+        std::cout << fmt::format("  {:<10} {:>9.0f} requests/s  allocations/request: {:>6.2f}  "
+                                 "instructions/request: {}  p50: {:>6.3f} ms  p99: {:>6.3f} ms",
+                                 name, requests / static_cast<double>(duration.count()),
+                                 static_cast<double>(result.allocations) / requests, instructions,
+                                 percentile(result.latencies_ms, 0.5), percentile(result.latencies_ms, 0.99))
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,186 @@
+// Slow connect benchmark: keep-alive clients request the locally served
+// stats endpoint of the in-process proxy while other clients keep opening
+// connections that send nothing (or dribble a single byte), as a slow or
+// hostile client would.
+// Requests/s and latency percentiles of the normal clients are compared
+// with and without the idle connections: with the protocol detection
+// blocking an io thread, the figures collapse once every worker thread waits
+// on a silent connection.
+//
+// usage: slow_connect_bench [idle connects per second] [seconds per step]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "server.h"
+
+using asio::ip::tcp;
+
+namespace
+{
+    constexpr size_t server_threads = 3;
+    constexpr size_t clients = 8;
+
+    struct Result
+    {
+        double rate = 0;
+        std::vector<double> latencies_ms;
+    };
+
+    // one request at a time on a keep-alive connection
+    void run_client(const tcp::endpoint& endpoint, const std::atomic<bool>& stopping, Result& result,
+                    std::mutex& mutex)
+    {
+        asio::io_context io;
+        tcp::socket socket(io);
+        asio::error_code ec;
+        socket.connect(endpoint, ec);
+        if (ec)
+            return;
+        socket.set_option(tcp::no_delay(true));
+
+        const std::string request = fmt::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", stats_target);
+        asio::streambuf buffer;
+        std::vector<double> latencies;
+
+        while (!stopping)
+        {
+            const auto started_at = std::chrono::steady_clock::now();
+
+            asio::write(socket, asio::buffer(request), ec);
+            const size_t n = ec ? 0 : asio::read_until(socket, buffer, "\r\n\r\n", ec);
+            if (ec)
+                break;
+
+            std::string header(asio::buffers_begin(buffer.data()), asio::buffers_begin(buffer.data()) + n);
+            buffer.consume(n);
+            const auto pos = header.find("Content-Length: ");
+            const size_t length = (pos == std::string::npos) ? 0 : std::strtoull(header.c_str() + pos + 16, nullptr, 10);
+            if (buffer.size() < length)
+                asio::read(socket, buffer, asio::transfer_exactly(length - buffer.size()), ec);
+            if (ec)
+                break;
+            buffer.consume(length);
+
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_at).count());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result.latencies_ms.insert(result.latencies_ms.end(), latencies.begin(), latencies.end());
+    }
+
+    // opens connections at the given rate and keeps them silent (every other one sends a single byte)
+    void run_idle_connects(const tcp::endpoint& endpoint, size_t per_second, const std::atomic<bool>& stopping)
+    {
+        asio::io_context io;
+        std::vector<tcp::socket> sockets;
+        const auto interval = std::chrono::microseconds(1000000 / std::max<size_t>(per_second, 1));
+
+        for (size_t i = 0; !stopping; i++)
+        {
+            tcp::socket socket(io);
+            asio::error_code ec;
+            socket.connect(endpoint, ec);
+            if (!ec)
+            {
+                if (i % 2)
+                    asio::write(socket, asio::buffer("G", 1), ec);
+                sockets.push_back(std::move(socket));
+            }
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    Result run_step(unsigned short port, size_t idle_per_second, std::chrono::seconds duration)
+    {
+        ServerOptions server_options;
+        server_options.threads = server_threads;
+        UpstreamPool::Options pool_options;
+        pool_options.min_size = 0;
+
+        Server server(port, ServerRunningMode::Persistent, server_options, pool_options);
+        std::thread server_thread([&server]()
+                                  { server.run(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        const tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+        std::atomic<bool> stopping{false};
+        Result result;
+        std::mutex mutex;
+
+        std::thread idle;
+        if (idle_per_second > 0)
+        {
+            idle = std::thread([&]()
+                               { run_idle_connects(endpoint, idle_per_second, stopping); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < clients; i++)
+            threads.emplace_back([&]()
+                                 { run_client(endpoint, stopping, result, mutex); });
+
+        std::this_thread::sleep_for(duration);
+        stopping = true;
+        for (auto& thread : threads)
+            thread.join();
+        if (idle.joinable())
+            idle.join();
+
+        std::raise(SIGINT); // graceful server shutdown
+        server_thread.join();
+
+        result.rate = static_cast<double>(result.latencies_ms.size()) / static_cast<double>(duration.count());
+        std::sort(result.latencies_ms.begin(), result.latencies_ms.end());
+        return result;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t idle_per_second = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const std::chrono::seconds duration((argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 3);
+
+    gl_logger = spdlog::default_logger();
+    gl_logger->set_level(spdlog::level::off);
+
+    std::cout << fmt::format("{} keep-alive clients, {} server threads, {} s per step", clients, server_threads,
+                             duration.count())
+              << std::endl;
+
+    unsigned short port = 18180;
+    for (const auto& [name, rate] : {std::make_pair(std::string("no idle connects"), size_t(0)),
+                                     std::make_pair(fmt::format("{} idle connects/s", idle_per_second), idle_per_second)})
+    {
+        const Result result = run_step(port++, rate, duration);
+        std::cout << fmt::format("  {:<22} {:>10.0f} requests/s  p50: {:>7.3f} ms  p99: {:>7.3f} ms  max: {:>8.3f} ms",
+                                 name, result.rate, percentile(result.latencies_ms, 0.5),
+                                 percentile(result.latencies_ms, 0.99),
+                                 result.latencies_ms.empty() ? 0.0 : result.latencies_ms.back())
+                  << std::endl;
+    }
+    return 0;
+}
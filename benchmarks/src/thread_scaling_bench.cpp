@@ -0,0 +1,200 @@
+// Worker thread scaling benchmark: the proxy runs in-process with 1..N
+// worker threads, keep-alive clients pipeline requests for the locally
+// served stats endpoint, so the upstream isn't involved and the figures
+// reflect the Server/HTTPSession request path only.
+// Each step is run with the shared io_context engine and the io_context
+// per core one.
+// The clients run on their own threads of the same machine, the figures
+// flatten out once server and clients compete for the CPUs.
+//
+// usage: thread_scaling_bench [max threads] [seconds per step]
+
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "server.h"
+#include "utils/cpu-resources.h"
+
+using asio::ip::tcp;
+
+namespace
+{
+    constexpr size_t client_threads = 2;
+    constexpr size_t connections = 64;
+    constexpr size_t pipeline_depth = 4;
+
+    std::atomic<uint64_t> responses{0};
+    std::atomic<bool> stopping{false};
+
+    class Client : public std::enable_shared_from_this<Client>
+    {
+    public:
+        explicit Client(asio::io_context& io) : socket_(io)
+        {
+            for (size_t i = 0; i < pipeline_depth; i++)
+                requests_ += fmt::format("GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", stats_target);
+        }
+
+        void start(const tcp::endpoint& endpoint)
+        {
+            socket_.connect(endpoint);
+            socket_.set_option(tcp::no_delay(true));
+            send();
+        }
+
+    private:
+        void send()
+        {
+            if (stopping)
+            {
+                asio::error_code ec;
+                socket_.shutdown(tcp::socket::shutdown_both, ec);
+                return;
+            }
+
+            auto self = shared_from_this();
+            pending_ = pipeline_depth;
+            asio::async_write(socket_, asio::buffer(requests_),
+                              [this, self](const asio::error_code& ec, size_t)
+                              {
+                                  if (!ec)
+                                      read_header();
+                              });
+        }
+
+        void read_header()
+        {
+            auto self = shared_from_this();
+            asio::async_read_until(socket_, buffer_, "\r\n\r\n",
+                                   [this, self](const asio::error_code& ec, size_t n)
+                                   {
+                                       if (ec)
+                                           return;
+
+                                       std::string header(asio::buffers_begin(buffer_.data()),
+                                                          asio::buffers_begin(buffer_.data()) + n);
+                                       buffer_.consume(n);
+
+                                       const auto pos = header.find("Content-Length: ");
+                                       const size_t length = (pos == std::string::npos)
+                                                                 ? 0
+                                                                 : std::strtoull(header.c_str() + pos + 16, nullptr, 10);
+                                       read_body(length);
+                                   });
+        }
+
+        void read_body(size_t length)
+        {
+            auto self = shared_from_this();
+            const size_t missing = (buffer_.size() >= length) ? 0 : length - buffer_.size();
+            asio::async_read(socket_, buffer_, asio::transfer_exactly(missing),
+                             [this, self, length](const asio::error_code& ec, size_t)
+                             {
+                                 if (ec)
+                                     return;
+
+                                 buffer_.consume(length);
+                                 responses.fetch_add(1, std::memory_order_relaxed);
+
+                                 if (--pending_ > 0)
+                                     read_header();
+                                 else
+                                     send();
+                             });
+        }
+
+    private:
+        tcp::socket socket_;
+        asio::streambuf buffer_;
+        std::string requests_;
+        size_t pending_ = 0;
+    };
+
+    double run_step(EngineMode engine, size_t threads, unsigned short port, std::chrono::seconds duration)
+    {
+        ServerOptions server_options;
+        server_options.threads = threads;
+        server_options.engine = engine;
+        UpstreamPool::Options pool_options;
+        pool_options.min_size = 0;
+
+        Server server(port, ServerRunningMode::Persistent, server_options, pool_options);
+        std::thread server_thread([&server]()
+                                  { server.run(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        responses = 0;
+        stopping = false;
+
+        asio::io_context io;
+        const tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), port);
+        for (size_t i = 0; i < connections; i++)
+            std::make_shared<Client>(io)->start(endpoint);
+
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < client_threads; i++)
+            clients.emplace_back([&io]()
+                                 { io.run(); });
+
+        // warm-up, then measure
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const uint64_t started_with = responses.load();
+        const auto started_at = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(duration);
+        const uint64_t count = responses.load() - started_with;
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at);
+
+        stopping = true;
+        for (auto& client : clients)
+            client.join();
+
+        std::raise(SIGINT); // graceful server shutdown
+        server_thread.join();
+
+        return static_cast<double>(count) / elapsed.count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t max_threads = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : default_thread_count();
+    const std::chrono::seconds duration((argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 3);
+
+    gl_logger = spdlog::default_logger();
+    gl_logger->set_level(spdlog::level::off);
+
+    std::cout << fmt::format("{} connections x {} pipelined requests, {} client threads, {} s per step",
+                             connections, pipeline_depth, client_threads, duration.count())
+              << std::endl;
+
+    double single(0);
+    for (size_t threads = 1; threads <= max_threads; threads++)
+    {
+        const double shared = run_step(EngineMode::Shared, threads,
+                                       static_cast<unsigned short>(18080 + 2 * threads), duration);
+        const double per_core = run_step(EngineMode::PerCore, threads,
+                                         static_cast<unsigned short>(18081 + 2 * threads), duration);
+        if (threads == 1)
+            single = shared;
+
+        std::cout << fmt::format("  threads: {:>3}  shared: {:>10.0f} requests/s {:>5.2f}x"
+                                 "  per-core: {:>10.0f} requests/s {:>5.2f}x",
+                                 threads, shared, (single > 0) ? shared / single : 0.0,
+                                 per_core, (single > 0) ? per_core / single : 0.0)
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "client-stream.h"
+
+#include <cerrno>
+
+#include "common/stats.h"
+
+ClientStream::ClientStream(asio::ip::tcp::socket&& socket) : socket_(std::move(socket)) {}
+
+ClientStream::ClientStream(asio::ip::tcp::socket&& socket, SSL_CTX* tls_context)
+    : socket_(std::move(socket)), ssl_(SSL_new(tls_context))
+{
+    if (!ssl_)
+        return; // the handshake fails
+
+    // OpenSSL reads and writes the socket itself, would-block results are awaited with async_wait
+    asio::error_code ec_formal;
+    socket_.non_blocking(true, ec_formal);
+
+    SSL_set_fd(ssl_.get(), static_cast<int>(socket_.native_handle()));
+    SSL_set_accept_state(ssl_.get());
+}
+
+ClientStream::Step ClientStream::step(int result, asio::error_code& ec)
+{
+    if (result > 0)
+        return Step::Done;
+
+    switch (SSL_get_error(ssl_.get(), result))
+    {
+    case SSL_ERROR_WANT_READ:
+        return Step::WaitRead;
+    case SSL_ERROR_WANT_WRITE:
+        return Step::WaitWrite;
+    case SSL_ERROR_ZERO_RETURN:
+        ec = asio::error::eof;
+        break;
+    case SSL_ERROR_SYSCALL:
+        ec = errno ? asio::error_code(errno, asio::error::get_system_category())
+                   : asio::error_code(asio::error::eof);
+        break;
+    default:
+    {
+        const unsigned long error = ERR_get_error();
+        ec = error ? asio::error_code(static_cast<int>(error), asio::error::get_ssl_category())
+                   : asio::error_code(asio::error::connection_aborted);
+        break;
+    }
+    }
+    return Step::Failed;
+}
+
+bool ClientStream::handshake_step(asio::error_code& ec, Step& next)
+{
+    if (!ssl_)
+    {
+        ec = asio::error::no_memory;
+        return true;
+    }
+
+    ERR_clear_error();
+    const int result = SSL_do_handshake(ssl_.get());
+    if (result == 1)
+    {
+        // OpenSSL switches the socket to kTLS as soon as the session keys are set
+        // (SSL_OP_ENABLE_KTLS, kernel "tls" module, cipher supported by the kernel)
+        ktls_send_ = BIO_get_ktls_send(SSL_get_wbio(ssl_.get()));
+        ktls_receive_ = BIO_get_ktls_recv(SSL_get_rbio(ssl_.get()));
+
+        gl_stats.inbound_tls_handshakes.fetch_add(1, std::memory_order_relaxed);
+        if (SSL_session_reused(ssl_.get()))
+            gl_stats.inbound_tls_resumed.fetch_add(1, std::memory_order_relaxed);
+        if (ktls_send_)
+            gl_stats.inbound_ktls_send.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    next = step(result, ec);
+    if (next == Step::Failed)
+    {
+        gl_stats.inbound_tls_failures.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ClientStream::shutdown()
+{
+    if (ssl_ && SSL_is_init_finished(ssl_.get()))
+    {
+        // a single non-blocking attempt, the peer's close_notify isn't awaited
+        ERR_clear_error();
+        SSL_shutdown(ssl_.get());
+    }
+
+    asio::error_code ec_formal;
+    socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec_formal);
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+// Client connection of an HTTPSession: a plain TCP socket, or a TLS one
+// terminated by the proxy.
+// TLS runs directly on the socket descriptor instead of asio's memory BIOs,
+// so OpenSSL can hand the record layer over to the kernel (kTLS) once the
+// handshake is done; the responses are then written to the socket as they
+// are, gathered into a single call, and encrypted by the kernel.
+// Models AsyncReadStream/AsyncWriteStream for asio's composed operations,
+// the handlers are called on their associated executor.
+class ClientStream
+{
+public:
+    using executor_type = asio::ip::tcp::socket::executor_type;
+
+    explicit ClientStream(asio::ip::tcp::socket&& socket);
+    // TLS server side, SSL_CTX of TlsServerContext
+    ClientStream(asio::ip::tcp::socket&& socket, SSL_CTX* tls_context);
+
+    ClientStream(ClientStream&&) = default;
+    ClientStream& operator=(ClientStream&&) = default;
+
+    executor_type get_executor() { return socket_.get_executor(); }
+    asio::ip::tcp::socket& socket() { return socket_; }
+
+    bool tls() const { return ssl_ != nullptr; }
+    bool tls_resumed() const { return ssl_ && SSL_session_reused(ssl_.get()); }
+    bool ktls_send() const { return ktls_send_; }
+    bool ktls_receive() const { return ktls_receive_; }
+
+    template <typename Handler>
+    void async_handshake(Handler&& handler)
+    {
+        asio::async_compose<Handler, void(asio::error_code)>(HandshakeOp{this}, handler, socket_);
+    }
+
+    template <typename MutableBufferSequence, typename Handler>
+    void async_read_some(const MutableBufferSequence& buffers, Handler&& handler)
+    {
+        if (!ssl_)
+            socket_.async_read_some(buffers, std::forward<Handler>(handler));
+        else
+            asio::async_compose<Handler, void(asio::error_code, size_t)>(
+                TransferOp<true>{this, first_buffer<asio::mutable_buffer>(buffers)}, handler, socket_);
+    }
+
+    template <typename ConstBufferSequence, typename Handler>
+    void async_write_some(const ConstBufferSequence& buffers, Handler&& handler)
+    {
+        // records are built by the kernel, all the buffers go in one gathering write
+        if (!ssl_ || ktls_send_)
+            socket_.async_write_some(buffers, std::forward<Handler>(handler));
+        else
+            asio::async_compose<Handler, void(asio::error_code, size_t)>(
+                TransferOp<false>{this, first_buffer<asio::const_buffer>(buffers)}, handler, socket_);
+    }
+
+    // sends the TLS close_notify (best effort) and shuts the socket down
+    void shutdown();
+
+private:
+    struct SslDeleter
+    {
+        void operator()(SSL* ssl) const { SSL_free(ssl); }
+    };
+
+    enum class Step
+    {
+        Done,
+        WaitRead,
+        WaitWrite,
+        Failed
+    };
+
+    // SSL_accept/SSL_read/SSL_write result mapped to what the operation waits for
+    Step step(int result, asio::error_code& ec);
+    // true once the handshake is over (ec set if it failed), otherwise next tells what to wait for
+    bool handshake_step(asio::error_code& ec, Step& next);
+
+    template <typename Buffer, typename BufferSequence>
+    static Buffer first_buffer(const BufferSequence& buffers)
+    {
+        for (auto it = asio::buffer_sequence_begin(buffers); it != asio::buffer_sequence_end(buffers); ++it)
+            if (asio::buffer_size(*it) > 0)
+                return Buffer((*it).data(), (*it).size());
+        return Buffer();
+    }
+
+    template <typename Self>
+    void wait(Self& self, Step next)
+    {
+        socket_.async_wait((next == Step::WaitRead) ? asio::socket_base::wait_read : asio::socket_base::wait_write,
+                           std::move(self));
+    }
+
+    // a result available within the initiating call is posted, the handler is never called inline
+    template <typename Self, typename... Result>
+    static void finish(Self& self, bool initiating, std::optional<std::tuple<Result...>>& posted, Result... result)
+    {
+        if (!initiating)
+            return self.complete(result...);
+        posted.emplace(result...);
+        asio::post(std::move(self));
+    }
+
+    struct HandshakeOp
+    {
+        ClientStream* stream;
+        bool started = false;
+        std::optional<std::tuple<asio::error_code>> posted{};
+
+        template <typename Self>
+        void operator()(Self& self, asio::error_code ec = {})
+        {
+            if (posted)
+                return self.complete(std::get<0>(*posted));
+
+            const bool initiating = !std::exchange(started, true);
+            Step next = Step::Failed;
+            if (!ec && !stream->handshake_step(ec, next))
+                return stream->wait(self, next);
+            finish(self, initiating, posted, ec);
+        }
+    };
+
+    // SSL_read (Read) or SSL_write of a single buffer
+    template <bool Read>
+    struct TransferOp
+    {
+        ClientStream* stream;
+        std::conditional_t<Read, asio::mutable_buffer, asio::const_buffer> buffer;
+        bool started = false;
+        std::optional<std::tuple<asio::error_code, size_t>> posted{};
+
+        template <typename Self>
+        void operator()(Self& self, asio::error_code ec = {})
+        {
+            if (posted)
+                return std::apply([&self](auto... result)
+                                  { self.complete(result...); },
+                                  *posted);
+
+            const bool initiating = !std::exchange(started, true);
+            if (ec || (buffer.size() == 0))
+                return finish(self, initiating, posted, ec, size_t(0));
+
+            SSL* ssl = stream->ssl_.get();
+            ERR_clear_error();
+            const int size = static_cast<int>(std::min<size_t>(buffer.size(), INT_MAX));
+            int result = 0;
+            if constexpr (Read)
+                result = SSL_read(ssl, buffer.data(), size);
+            else
+                result = SSL_write(ssl, buffer.data(), size);
+
+            const Step next = stream->step(result, ec);
+            if ((next == Step::WaitRead) || (next == Step::WaitWrite))
+                return stream->wait(self, next);
+            finish(self, initiating, posted, ec, (next == Step::Done) ? static_cast<size_t>(result) : size_t(0));
+        }
+    };
+
+private:
+    asio::ip::tcp::socket socket_;
+    std::unique_ptr<SSL, SslDeleter> ssl_;
+    bool ktls_send_ = false;
+    bool ktls_receive_ = false;
+};
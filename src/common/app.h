@@ -9,6 +9,10 @@ struct ClArguments
     ServerRunningMode running_mode = ServerRunningMode::Persistent;
     spdlog::level::level_enum log_level = spdlog::level::level_enum::info; // default log level
     LoggerType logger_type = LoggerType::Console;
+    ServerOptions server;
+    UpstreamPool::Options upstream_pool;
+    SessionOptions session;
+    ResponseCache::Options response_cache;
 };
 
 void show_usage(const cxxopts::Options& options);
@@ -25,7 +29,14 @@ inline std::pair<int, bool> process_arguments(int argc, char* argv[], ClArgument
         options.positional_help("[optional args]").show_positional_help();
 
         std::string log_level(SPDLOG_LEVEL_NAME_INFO.data(), SPDLOG_LEVEL_NAME_INFO.size());
-        std::string running_mode, log_type;
+        std::string running_mode, log_type, relay_mode, engine, session_engine;
+        size_t pool_idle_timeout(args.upstream_pool.idle_timeout.count());
+        size_t dns_ttl(args.upstream_pool.dns_ttl.count());
+        size_t connect_stagger(args.upstream_pool.connect_stagger.count());
+        size_t keep_alive_timeout(args.session.keep_alive_timeout.count());
+        size_t first_byte_timeout(args.server.first_byte_timeout.count());
+        size_t cache_size(args.response_cache.max_size / (1024 * 1024));
+        std::vector<std::string> cache_rules;
 
         // clang-format off
         options.add_options()("p, port", "specify port (default: 8080)",
@@ -34,8 +45,48 @@ inline std::pair<int, bool> process_arguments(int argc, char* argv[], ClArgument
                               cxxopts::value<std::string>(log_type)->default_value("console"))
                                ("r, run-mode", "specify running mode (persist, single-request)",
                               cxxopts::value<std::string>(running_mode)->default_value("persist"))
+                              ("threads", "worker threads (default: one per available CPU, container quota respected)",
+                              cxxopts::value<size_t>(args.server.threads))
+                              ("pin-threads", "bind each worker thread to its own CPU")
+                              ("engine", "specify threading engine (shared, per-core)",
+                              cxxopts::value<std::string>(engine)->default_value("shared"))
+                              ("session-engine", "specify client session engine (callback, coroutine; the latter requires an MB_COROUTINES build)",
+                              cxxopts::value<std::string>(session_engine)->default_value("callback"))
+                              ("relay-mode", "specify upstream response relay mode (stream, buffer)",
+                              cxxopts::value<std::string>(relay_mode)->default_value("stream"))
+                              ("keep-alive-timeout", "client keep-alive idle timeout, seconds, 0 disables keep-alive (default: 15)",
+                              cxxopts::value<size_t>(keep_alive_timeout))
+                              ("tls-port", "serve HTTPS on this port as well (requires --tls-cert and --tls-key)",
+                              cxxopts::value<decltype(args.server.tls.port)>(args.server.tls.port))
+                              ("tls-cert", "TLS server certificate chain file (PEM)",
+                              cxxopts::value<std::string>(args.server.tls.certificate_file))
+                              ("tls-key", "TLS server private key file (PEM)",
+                              cxxopts::value<std::string>(args.server.tls.private_key_file))
+                              ("session-pool", "session objects of each kind kept for reuse per worker thread, 0 disables the reuse (default: 256)",
+                              cxxopts::value<size_t>(args.server.session_pool))
+                              ("pending-accepts", "accepts kept outstanding on each listening socket (default: 4)",
+                              cxxopts::value<size_t>(args.server.pending_accepts))
+                              ("listen-backlog", "listening socket accept queue length (default: system maximum)",
+                              cxxopts::value<int>(args.server.listen_backlog))
+                              ("first-byte-timeout", "time a new client connection has to start its request, milliseconds (default: 2000)",
+                              cxxopts::value<size_t>(first_byte_timeout))
+                              ("no-coalescing", "fetch identical concurrent requests separately")
+                              ("cache-size", "response cache memory budget, MB, 0 disables the cache (default: 64)",
+                              cxxopts::value<size_t>(cache_size))
+                              ("cache-rule", "response cache TTL rule: <path prefix>=<milliseconds>, 0 bypasses the cache",
+                              cxxopts::value<std::vector<std::string>>(cache_rules))
                               ("l, log-level", "specify log level (error, warning, trace, debug, critical, off) (default: info)",
                               cxxopts::value<std::string>(log_level))
+                              ("pool-min", "upstream connections kept warm (default: 2)",
+                              cxxopts::value<size_t>(args.upstream_pool.min_size))
+                              ("pool-max", "upstream idle connections retained (default: 32)",
+                              cxxopts::value<size_t>(args.upstream_pool.max_size))
+                              ("pool-idle-timeout", "upstream idle connection timeout, seconds (default: 30)",
+                              cxxopts::value<size_t>(pool_idle_timeout))
+                              ("dns-ttl", "upstream host resolution refresh interval, seconds (default: 60)",
+                              cxxopts::value<size_t>(dns_ttl))
+                              ("connect-stagger", "delay between racing upstream connect attempts, milliseconds (default: 250)",
+                              cxxopts::value<size_t>(connect_stagger))
                               ("h, help", "print usage");
         // clang-format on
 
@@ -59,6 +110,81 @@ inline std::pair<int, bool> process_arguments(int argc, char* argv[], ClArgument
                 if (running_mode == "single-request")
                     args.running_mode = ServerRunningMode::SingleRequest;
             }
+            if (!engine.empty())
+            {
+                if (engine == "per-core")
+                    args.server.engine = EngineMode::PerCore;
+            }
+            if (session_engine == "coroutine")
+            {
+#ifdef MB_COROUTINES
+                args.server.session_engine = SessionEngine::Coroutine;
+#else
+                std::cout << "command line arguments parsing error: --session-engine coroutine requires a build "
+                             "with MB_COROUTINES"
+                          << std::endl;
+                result.first = 1;
+                return result;
+#endif
+            }
+            if (!relay_mode.empty())
+            {
+                if (relay_mode == "buffer")
+                    args.session.relay_mode = RelayMode::Buffered;
+            }
+            if (parsed_args.count("pin-threads"))
+                args.server.pin_threads = true;
+            if (parsed_args.count("no-coalescing"))
+                args.session.coalescing = false;
+            if ((args.server.pending_accepts == 0) || (args.server.listen_backlog < 0))
+            {
+                std::cout << "command line arguments parsing error: --pending-accepts and --listen-backlog "
+                             "must be positive"
+                          << std::endl;
+                result.first = 1;
+                return result;
+            }
+            // warm connections beyond those retained, or evicted as soon as warmed, would be reconnected forever
+            if ((args.upstream_pool.min_size > args.upstream_pool.max_size) || (pool_idle_timeout == 0))
+            {
+                std::cout << "command line arguments parsing error: --pool-min must not exceed --pool-max, "
+                             "--pool-idle-timeout must be positive"
+                          << std::endl;
+                result.first = 1;
+                return result;
+            }
+            if (dns_ttl == 0)
+            {
+                std::cout << "command line arguments parsing error: --dns-ttl must be positive" << std::endl;
+                result.first = 1;
+                return result;
+            }
+            if ((args.server.tls.port != 0) &&
+                (args.server.tls.certificate_file.empty() || args.server.tls.private_key_file.empty()))
+            {
+                std::cout << "command line arguments parsing error: --tls-port requires --tls-cert and --tls-key"
+                          << std::endl;
+                result.first = 1;
+                return result;
+            }
+            for (const auto& text : cache_rules)
+            {
+                auto rule = ResponseCache::parse_rule(text);
+                if (!rule)
+                {
+                    std::cout << "command line arguments parsing error: invalid cache rule '" << text << "'"
+                              << std::endl;
+                    result.first = 1;
+                    return result;
+                }
+                ResponseCache::add_rule(args.response_cache.rules, std::move(*rule));
+            }
+            args.response_cache.max_size = cache_size * 1024 * 1024;
+            args.session.keep_alive_timeout = std::chrono::seconds(keep_alive_timeout);
+            args.server.first_byte_timeout = std::chrono::milliseconds(first_byte_timeout);
+            args.upstream_pool.idle_timeout = std::chrono::seconds(pool_idle_timeout);
+            args.upstream_pool.dns_ttl = std::chrono::seconds(dns_ttl);
+            args.upstream_pool.connect_stagger = std::chrono::milliseconds(connect_stagger);
         }
 
         if (result.second)
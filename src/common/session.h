@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 
 struct Session
@@ -9,4 +10,17 @@ struct Session
     virtual uint64_t get_id() = 0;
 
     virtual ~Session() =  default;
-};
\ No newline at end of file
+};
+
+enum class RelayMode
+{
+    Streaming, // upstream response is forwarded chunk by chunk as it arrives
+    Buffered   // upstream response is forwarded once completely received
+};
+
+struct SessionOptions
+{
+    RelayMode relay_mode = RelayMode::Streaming;
+    std::chrono::seconds keep_alive_timeout{15}; // client idle timeout, 0 disables keep-alive
+    bool coalescing = true;                      // identical in-flight requests share one upstream fetch
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <spdlog/fmt/fmt.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// local endpoint serving the counters (not forwarded upstream)
+inline constexpr auto stats_target = "/market-bridge/stats";
+
+// Counters keyed by name (e.g. endpoint path), the number of distinct keys is bounded
+class KeyedCounters
+{
+public:
+    constexpr static size_t max_keys = 256;
+
+    void add(std::string_view key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = counters_.find(key);
+        if (it == counters_.end())
+        {
+            if (counters_.size() >= max_keys)
+                key = "(other)";
+            it = counters_.emplace(std::string(key), 0).first;
+        }
+        it->second++;
+    }
+
+    std::string to_json() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string result("{");
+        for (const auto& [key, count] : counters_)
+        {
+            if (result.size() > 1)
+                result += ',';
+            result += '"';
+            for (char c : key)
+            {
+                if ((c == '"') || (c == '\\'))
+                    result += '\\';
+                if (static_cast<unsigned char>(c) >= 0x20)
+                    result += c;
+            }
+            result += fmt::format(R"(":{})", count);
+        }
+        result += '}';
+        return result;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, uint64_t, std::less<>> counters_;
+};
+
+// Process-wide runtime counters
+struct Stats
+{
+    std::atomic<uint64_t> upstream_connections_created{0};
+    std::atomic<uint64_t> upstream_connections_reused{0};
+    std::atomic<uint64_t> upstream_connections_evicted{0};
+    std::atomic<uint64_t> tls_context_build_us{0};
+    std::atomic<uint64_t> tls_handshakes_full{0};
+    std::atomic<uint64_t> tls_handshakes_resumed{0};
+    std::atomic<uint64_t> inbound_tls_handshakes{0};
+    std::atomic<uint64_t> inbound_tls_resumed{0};
+    std::atomic<uint64_t> inbound_tls_failures{0};
+    std::atomic<uint64_t> inbound_ktls_send{0}; // handshakes followed by kernel TLS writes
+    std::atomic<uint64_t> dns_resolutions{0};
+    std::atomic<uint64_t> dns_failures{0};
+    std::atomic<uint64_t> connect_attempts{0};
+    std::atomic<uint64_t> connect_failures{0};
+    std::atomic<uint64_t> client_connections{0};
+    std::atomic<uint64_t> client_requests{0};
+    std::atomic<uint64_t> client_sessions{0}; // currently open client connections
+    std::atomic<uint64_t> client_first_byte_timeouts{0};
+    std::atomic<uint64_t> client_pipelined_requests{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> accept_errors{0};
+    std::atomic<uint64_t> accept_queue_peak{0}; // most connections seen waiting in an accept queue
+    // since the server has started, all the listening sockets of the network namespace (kernel),
+    // not only the server's own
+    std::atomic<uint64_t> namespace_listen_overflows{0};
+    std::atomic<uint64_t> namespace_listen_drops{0};
+    std::atomic<uint64_t> upstream_failures{0};
+    std::atomic<uint64_t> session_pool_hits{0}; // recycled blocks (utils/recycling-pool.h, collected)
+    std::atomic<uint64_t> session_pool_misses{0};
+    std::atomic<uint64_t> exchange_pool_hits{0};
+    std::atomic<uint64_t> exchange_pool_misses{0};
+    std::atomic<uint64_t> outgoing_pool_hits{0};
+    std::atomic<uint64_t> outgoing_pool_misses{0};
+    std::atomic<uint64_t> handler_memory_fallbacks{0}; // handler operations allocated on the heap
+    std::atomic<uint64_t> coalescing_leaders{0};
+    std::atomic<uint64_t> coalescing_followers{0};
+    KeyedCounters coalescing_hits; // followers per endpoint path
+    std::atomic<uint64_t> cache_hits{0};
+    std::atomic<uint64_t> cache_stale_hits{0};
+    std::atomic<uint64_t> cache_refreshes{0};
+    std::atomic<uint64_t> cache_refreshes_ahead{0};
+    std::atomic<uint64_t> cache_misses{0};
+    std::atomic<uint64_t> cache_bypassed{0};
+    std::atomic<uint64_t> cache_stores{0};
+    std::atomic<uint64_t> cache_evictions{0};
+    std::atomic<uint64_t> cache_size{0}; // bytes currently held
+
+    static double ratio(uint64_t part, uint64_t total)
+    {
+        return total ? static_cast<double>(part) / static_cast<double>(total) : 0.0;
+    }
+
+    // collector: adds counters kept per thread elsewhere to the stats, run before they're read
+    void add_collector(void (*collector)())
+    {
+        std::lock_guard<std::mutex> lock(collectors_mutex_);
+        collectors_.push_back(collector);
+    }
+
+    void collect() const
+    {
+        std::lock_guard<std::mutex> lock(collectors_mutex_);
+        for (const auto collector : collectors_)
+            collector();
+    }
+
+    std::string to_json() const
+    {
+        collect();
+
+        const uint64_t handshakes_full = tls_handshakes_full.load(std::memory_order_relaxed);
+        const uint64_t handshakes_resumed = tls_handshakes_resumed.load(std::memory_order_relaxed);
+        const uint64_t hits = cache_hits.load(std::memory_order_relaxed);
+        const uint64_t misses = cache_misses.load(std::memory_order_relaxed);
+
+        return fmt::format(R"({{"client":{{"connections":{},"active":{},"requests":{},"pipelined":{},"upstream_failures":{},)"
+                           R"("first_byte_timeouts":{}}},)"
+                           R"("accept":{{"accepted":{},"errors":{},"queue_peak":{},"namespace_listen_overflows":{},"namespace_listen_drops":{}}},)"
+                           R"("upstream_pool":{{"created":{},"reused":{},"evicted":{}}},)"
+                           R"("session_pool":{{"session_hits":{},"session_misses":{},"exchange_hits":{},)"
+                           R"("exchange_misses":{},"outgoing_hits":{},"outgoing_misses":{},"handler_fallbacks":{}}},)"
+                           R"("tls":{{"context_build_us":{},"handshakes_full":{},"handshakes_resumed":{},)"
+                           R"("resumption_ratio":{:.3f}}},)"
+                           R"("inbound_tls":{{"handshakes":{},"resumed":{},"failures":{},"ktls_send":{}}},)"
+                           R"("dns":{{"resolutions":{},"failures":{}}},)"
+                           R"("connect":{{"attempts":{},"failures":{}}},)"
+                           R"("coalescing":{{"leaders":{},"followers":{},"endpoints":{}}},)"
+                           R"("cache":{{"hits":{},"misses":{},"hit_ratio":{:.3f},"bypassed":{},"stored":{},)"
+                           R"("evicted":{},"size":{},"stale_hits":{},"refreshes":{},"refreshes_ahead":{}}}}})",
+                           client_connections.load(std::memory_order_relaxed),
+                           client_sessions.load(std::memory_order_relaxed),
+                           client_requests.load(std::memory_order_relaxed),
+                           client_pipelined_requests.load(std::memory_order_relaxed),
+                           upstream_failures.load(std::memory_order_relaxed),
+                           client_first_byte_timeouts.load(std::memory_order_relaxed),
+                           accepted.load(std::memory_order_relaxed),
+                           accept_errors.load(std::memory_order_relaxed),
+                           accept_queue_peak.load(std::memory_order_relaxed),
+                           namespace_listen_overflows.load(std::memory_order_relaxed),
+                           namespace_listen_drops.load(std::memory_order_relaxed),
+                           upstream_connections_created.load(std::memory_order_relaxed),
+                           upstream_connections_reused.load(std::memory_order_relaxed),
+                           upstream_connections_evicted.load(std::memory_order_relaxed),
+                           session_pool_hits.load(std::memory_order_relaxed),
+                           session_pool_misses.load(std::memory_order_relaxed),
+                           exchange_pool_hits.load(std::memory_order_relaxed),
+                           exchange_pool_misses.load(std::memory_order_relaxed),
+                           outgoing_pool_hits.load(std::memory_order_relaxed),
+                           outgoing_pool_misses.load(std::memory_order_relaxed),
+                           handler_memory_fallbacks.load(std::memory_order_relaxed),
+                           tls_context_build_us.load(std::memory_order_relaxed),
+                           handshakes_full, handshakes_resumed,
+                           ratio(handshakes_resumed, handshakes_full + handshakes_resumed),
+                           inbound_tls_handshakes.load(std::memory_order_relaxed),
+                           inbound_tls_resumed.load(std::memory_order_relaxed),
+                           inbound_tls_failures.load(std::memory_order_relaxed),
+                           inbound_ktls_send.load(std::memory_order_relaxed),
+                           dns_resolutions.load(std::memory_order_relaxed),
+                           dns_failures.load(std::memory_order_relaxed),
+                           connect_attempts.load(std::memory_order_relaxed),
+                           connect_failures.load(std::memory_order_relaxed),
+                           coalescing_leaders.load(std::memory_order_relaxed),
+                           coalescing_followers.load(std::memory_order_relaxed),
+                           coalescing_hits.to_json(),
+                           hits, misses, ratio(hits, hits + misses),
+                           cache_bypassed.load(std::memory_order_relaxed),
+                           cache_stores.load(std::memory_order_relaxed),
+                           cache_evictions.load(std::memory_order_relaxed),
+                           cache_size.load(std::memory_order_relaxed),
+                           cache_stale_hits.load(std::memory_order_relaxed),
+                           cache_refreshes.load(std::memory_order_relaxed),
+                           cache_refreshes_ahead.load(std::memory_order_relaxed));
+    }
+
+private:
+    mutable std::mutex collectors_mutex_;
+    std::vector<void (*)()> collectors_;
+};
+
+inline Stats gl_stats;
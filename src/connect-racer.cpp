@@ -0,0 +1,212 @@
+#include "connect-racer.h"
+
+#include <algorithm>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+
+std::vector<tcp::endpoint> EndpointScores::order(const std::vector<tcp::endpoint>& endpoints) const
+{
+    std::vector<std::pair<std::chrono::microseconds, tcp::endpoint>> scored;
+    scored.reserve(endpoints.size());
+    for (const auto& endpoint : endpoints)
+        scored.emplace_back(score(endpoint), endpoint);
+
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const auto& a, const auto& b)
+                     { return a.first < b.first; });
+
+    std::vector<tcp::endpoint> result;
+    result.reserve(scored.size());
+    for (auto& [rtt, endpoint] : scored)
+        result.push_back(endpoint);
+    return result;
+}
+
+void EndpointScores::record_rtt(const tcp::endpoint& endpoint, std::chrono::microseconds rtt)
+{
+    update(endpoint, std::max(rtt, std::chrono::microseconds(1)));
+}
+
+void EndpointScores::record_failure(const tcp::endpoint& endpoint)
+{
+    update(endpoint, failure_penalty);
+}
+
+void EndpointScores::record_outpaced(const tcp::endpoint& endpoint, std::chrono::microseconds elapsed,
+                                     std::chrono::microseconds winner_score)
+{
+    // elapsed is a lower bound of the RTT, often a short one (a staggered attempt starts late)
+    const auto sample = std::max(elapsed, winner_score + std::chrono::microseconds(1));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto [it, inserted] = scores_.emplace(endpoint.address(), sample);
+    if (!inserted)
+        it->second = std::max(it->second, (it->second * 3 + sample) / 4);
+}
+
+std::chrono::microseconds EndpointScores::score(const tcp::endpoint& endpoint) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = scores_.find(endpoint.address());
+    return (it != scores_.end()) ? it->second : std::chrono::microseconds(0);
+}
+
+void EndpointScores::update(const tcp::endpoint& endpoint, std::chrono::microseconds sample)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto [it, inserted] = scores_.emplace(endpoint.address(), sample);
+    if (!inserted)
+        it->second = (it->second * 3 + sample) / 4; // EWMA, alpha = 1/4
+}
+
+ConnectRacer::ConnectRacer(asio::io_context& io, const std::vector<tcp::endpoint>& endpoints,
+                           EndpointScores& scores, std::chrono::milliseconds stagger,
+                           ConnectHandler handler)
+    : io_(io), strand_(asio::make_strand(io.get_executor())), endpoints_(scores.order(endpoints)),
+      scores_(scores), stagger_(stagger), handler_(std::move(handler)),
+      stagger_timer_(strand_), deadline_timer_(strand_) {}
+
+void ConnectRacer::start()
+{
+    auto self = shared_from_this();
+
+    asio::dispatch(strand_, [this, self]()
+                   {
+                       if (endpoints_.empty())
+                       {
+                           finish(asio::error::host_not_found, 0);
+                           return;
+                       }
+
+                       deadline_timer_.expires_after(connect_timeout);
+                       deadline_timer_.async_wait([this, self](const asio::error_code& ec)
+                                                  {
+                                                      if (ec != asio::error::operation_aborted)
+                                                          finish(asio::error::timed_out, 0);
+                                                  });
+                       start_attempt();
+                   });
+}
+
+void ConnectRacer::start_attempt()
+{
+    const size_t index = sockets_.size();
+    if (index >= endpoints_.size())
+        return;
+
+    const auto& endpoint = endpoints_[index];
+
+    gl_logger->debug("ConnectRacer, attempt {} to {}", index, endpoint.address().to_string());
+    gl_stats.connect_attempts.fetch_add(1, std::memory_order_relaxed);
+
+    sockets_.push_back(std::make_unique<tcp::socket>(io_));
+    started_at_.push_back(std::chrono::steady_clock::now());
+    completed_.push_back(false);
+    pending_++;
+
+    auto self = shared_from_this();
+
+    sockets_.back()->async_connect(endpoint,
+                                   asio::bind_executor(strand_,
+                                                       [this, self, index](const asio::error_code& ec)
+                                                       {
+                                                           on_attempt(index, ec);
+                                                       }));
+
+    if (sockets_.size() < endpoints_.size())
+        schedule_next_attempt();
+}
+
+void ConnectRacer::schedule_next_attempt()
+{
+    auto self = shared_from_this();
+
+    // a wait completed before being cancelled may still be queued on the strand,
+    // the attempt it was scheduled for has then been started by a failure already
+    const size_t attempt = sockets_.size();
+
+    stagger_timer_.expires_after(stagger_);
+    stagger_timer_.async_wait([this, self, attempt](const asio::error_code& ec)
+                              {
+                                  if (!done_ && (ec != asio::error::operation_aborted) &&
+                                      (sockets_.size() == attempt))
+                                      start_attempt();
+                              });
+}
+
+void ConnectRacer::on_attempt(size_t index, const asio::error_code& ec)
+{
+    if (done_)
+        return;
+
+    pending_--;
+    completed_[index] = true;
+
+    const auto& endpoint = endpoints_[index];
+    if (!ec)
+    {
+        scores_.record_rtt(endpoint, std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now() - started_at_[index]));
+        finish(ec, index);
+        return;
+    }
+
+    gl_logger->warn("ConnectRacer, {} connect failure: {}", endpoint.address().to_string(), ec.message());
+    gl_stats.connect_failures.fetch_add(1, std::memory_order_relaxed);
+
+    scores_.record_failure(endpoint);
+    last_ec_ = ec;
+
+    // a failed attempt doesn't wait for the stagger delay
+    if (sockets_.size() < endpoints_.size())
+    {
+        stagger_timer_.cancel();
+        start_attempt();
+    }
+    else if (pending_ == 0)
+    {
+        finish(last_ec_, 0);
+    }
+}
+
+void ConnectRacer::finish(const asio::error_code& ec, size_t winner)
+{
+    if (done_)
+        return;
+    done_ = true;
+
+    stagger_timer_.cancel();
+    deadline_timer_.cancel();
+
+    // cancel the remaining attempts
+    const auto now = std::chrono::steady_clock::now();
+    const auto winner_score = ec ? std::chrono::microseconds(0) : scores_.score(endpoints_[winner]);
+    for (size_t i = 0; i < sockets_.size(); i++)
+    {
+        if (!ec && (i == winner))
+            continue;
+
+        asio::error_code ec_formal;
+        sockets_[i]->close(ec_formal);
+
+        // an outpaced attempt only ever ranks lower, it isn't tried before the winner next time
+        if (!completed_[i])
+        {
+            if (ec)
+                scores_.record_failure(endpoints_[i]);
+            else
+                scores_.record_outpaced(endpoints_[i],
+                                        std::chrono::duration_cast<std::chrono::microseconds>(now - started_at_[i]),
+                                        winner_score);
+        }
+    }
+
+    if (ec)
+        handler_(ec, tcp::socket(io_));
+    else
+        handler_(ec, std::move(*sockets_[winner]));
+}
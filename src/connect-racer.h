@@ -0,0 +1,77 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using asio::ip::tcp;
+
+// Smoothed connect RTT per upstream IP, used to prefer the fastest edges
+class EndpointScores
+{
+    constexpr static auto failure_penalty = std::chrono::microseconds(1000000);
+
+public:
+    // orders endpoints by score, not yet measured ones are tried first (once)
+    std::vector<tcp::endpoint> order(const std::vector<tcp::endpoint>& endpoints) const;
+
+    void record_rtt(const tcp::endpoint& endpoint, std::chrono::microseconds rtt);
+    void record_failure(const tcp::endpoint& endpoint);
+    // an attempt cancelled after elapsed, once another one scored winner_score had connected:
+    // its score ends above the winner's eventually, it is never lowered
+    void record_outpaced(const tcp::endpoint& endpoint, std::chrono::microseconds elapsed,
+                         std::chrono::microseconds winner_score);
+
+    std::chrono::microseconds score(const tcp::endpoint& endpoint) const;
+
+private:
+    void update(const tcp::endpoint& endpoint, std::chrono::microseconds sample);
+
+private:
+    mutable std::mutex mutex_;
+    std::map<asio::ip::address, std::chrono::microseconds> scores_;
+};
+
+// Happy-eyeballs style connect: staggered attempts across the endpoint list,
+// the first established connection wins and the remaining attempts are cancelled
+class ConnectRacer : public std::enable_shared_from_this<ConnectRacer>
+{
+    constexpr static auto connect_timeout = std::chrono::seconds(10);
+
+public:
+    using ConnectHandler = std::function<void(const asio::error_code&, tcp::socket)>;
+
+    ConnectRacer(asio::io_context& io, const std::vector<tcp::endpoint>& endpoints,
+                 EndpointScores& scores, std::chrono::milliseconds stagger, ConnectHandler handler);
+
+    void start();
+
+private:
+    void start_attempt();
+    void schedule_next_attempt();
+    void on_attempt(size_t index, const asio::error_code& ec);
+    void finish(const asio::error_code& ec, size_t winner);
+
+private:
+    asio::io_context& io_;
+    asio::strand<asio::any_io_executor> strand_;
+    const std::vector<tcp::endpoint> endpoints_;
+    EndpointScores& scores_;
+    const std::chrono::milliseconds stagger_;
+    ConnectHandler handler_;
+    asio::steady_timer stagger_timer_;
+    asio::steady_timer deadline_timer_;
+    std::vector<std::unique_ptr<tcp::socket>> sockets_;
+    std::vector<std::chrono::steady_clock::time_point> started_at_;
+    std::vector<bool> completed_;
+    size_t pending_ = 0;
+    bool done_ = false;
+    asio::error_code last_ec_;
+};
@@ -0,0 +1,511 @@
+#ifdef MB_COROUTINES
+
+#include "coro-http-session.h"
+
+#include <array>
+#include <asio.hpp>
+#include <spdlog/fmt/fmt.h>
+
+#include "common/ec-handler.h"
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "utils/http-response-framer.h"
+
+namespace
+{
+    // a follower of a coalesced fetch waits on the timer until the leader's response is posted
+    struct FlightWaiter
+    {
+        explicit FlightWaiter(const asio::any_io_executor& executor) : signal(executor)
+        {
+            signal.expires_at(asio::steady_timer::time_point::max());
+        }
+
+        asio::steady_timer signal;
+        SharedBufferChain response; // null if the leader has failed
+        bool persistent = true;
+    };
+}
+
+CoroutineHTTPSession::CoroutineHTTPSession(asio::io_context& io, ClientStream&& stream,
+                                           asio::any_io_executor executor, uint64_t id,
+                                           UpstreamPool& upstream_pool, RequestCoalescer& coalescer,
+                                           ResponseCache& cache, const SessionOptions& options)
+    : io_(io), stream_(std::move(stream)), executor_(std::move(executor)),
+      idle_timer_(executor_), upstream_pool_(upstream_pool), coalescer_(coalescer), cache_(cache),
+      options_(options),
+      id_(id)
+{
+    gl_logger->trace("CoroutineHTTPSession constructed, id: {}", id_);
+}
+
+CoroutineHTTPSession::~CoroutineHTTPSession()
+{
+    gl_logger->trace("CoroutineHTTPSession destructed, id: {}, requests: {}", id_, requests_);
+}
+
+void CoroutineHTTPSession::start()
+{
+    gl_logger->info("CoroutineHTTPSession started, id: {} ...", id_);
+
+    gl_stats.client_connections.fetch_add(1, std::memory_order_relaxed);
+
+    asio::co_spawn(executor_, serve(shared_from_this()), asio::detached);
+}
+
+void CoroutineHTTPSession::start(SessionRegistry::Registration registration)
+{
+    registration_ = std::move(registration);
+    start();
+}
+
+void CoroutineHTTPSession::stop()
+{
+    gl_logger->info("CoroutineHTTPSession, stop pending, id: {} ...", id_);
+
+    auto self = shared_from_this();
+
+    // an idle keep-alive connection is closed right away,
+    // a busy one once the response being served has been sent
+    asio::dispatch(executor_, [this, self]()
+                   {
+                       stopped_ = true;
+                       if (awaiting_request_)
+                           close();
+                   });
+}
+
+// the session coroutine, self keeps the session alive until the connection is done
+asio::awaitable<void> CoroutineHTTPSession::serve(std::shared_ptr<CoroutineHTTPSession> self)
+{
+    asio::error_code ec;
+
+    while (!closed_ && !stopped_)
+    {
+        // a request received along with the previous one is pipelined
+        const bool pipelined = (buffer_.size() > 0);
+
+        awaiting_request_ = true;
+        arm_idle_timer();
+
+        // parsed in place as the bytes arrive, a pipelined request may already be complete
+        auto status = parse_buffered();
+        while (status == HttpRequestParser::Status::Incomplete)
+        {
+            co_await asio::async_read(stream_, buffer_, asio::transfer_at_least(1),
+                                      asio::redirect_error(asio::use_awaitable, ec));
+            if (ec)
+                break;
+            status = parse_buffered();
+        }
+
+        awaiting_request_ = false;
+        idle_timer_.cancel();
+
+        if (ec)
+        {
+            // the client closing an idle keep-alive connection is not an error
+            if ((requests_ == 0) || !(is_eof(ec) || (ec == asio::error::operation_aborted)))
+                check_ec(ec, __func__);
+            break;
+        }
+        if (stopped_)
+            break;
+
+        if (status == HttpRequestParser::Status::Error)
+        {
+            gl_logger->debug("CoroutineHTTPSession, malformed request, id: {}", id_);
+
+            HttpResponse response;
+            response.status_code = static_cast<int>(HTTPResponseCodes::BadRequest);
+            response.reason = "Bad Request";
+            response.headers.set(HeaderId::ContentType, "text/plain");
+            response.body = "malformed request";
+            co_await send(local_response(response, false), false);
+            break;
+        }
+
+        // the request owns its parts, a background refresh may outlive the receive buffer
+        const HttpRequest request = make_request(parser_);
+        buffer_.consume(parser_.size());
+        parser_.reset();
+        requests_++;
+
+        gl_stats.client_requests.fetch_add(1, std::memory_order_relaxed);
+        if (pipelined)
+            gl_stats.client_pipelined_requests.fetch_add(1, std::memory_order_relaxed);
+
+        const bool persistent = (options_.keep_alive_timeout.count() > 0) && is_keep_alive(request) &&
+                                allows_next_request(request);
+        if (!co_await respond(request, persistent))
+            break;
+    }
+
+    close();
+}
+
+// parses the received bytes in place, resuming where the previous call stopped
+HttpRequestParser::Status CoroutineHTTPSession::parse_buffered()
+{
+    const auto data = buffer_.data();
+    return parser_.parse(std::string_view(static_cast<const char*>(data.data()), data.size()));
+}
+
+void CoroutineHTTPSession::arm_idle_timer()
+{
+    if (options_.keep_alive_timeout.count() == 0)
+        return;
+
+    std::shared_ptr<CoroutineHTTPSession> self = shared_from_this();
+
+    idle_timer_.expires_after(options_.keep_alive_timeout);
+    idle_timer_.async_wait([this, self](const asio::error_code& ec)
+                           {
+                               if (ec != asio::error::operation_aborted)
+                               {
+                                   gl_logger->debug("CoroutineHTTPSession idle timeout, id: {}", id_);
+                                   close();
+                               }
+                           });
+}
+
+// answers the request locally, from the cache, by an identical request in flight or from the upstream,
+// returns true if the connection carries on
+asio::awaitable<bool> CoroutineHTTPSession::respond(const HttpRequest& request, bool persistent)
+{
+    if (request.target == stats_target)
+    {
+        HttpResponse response;
+        response.headers.set(HeaderId::ContentType, "application/json");
+        response.body = gl_stats.to_json();
+        co_return co_await send(local_response(response, persistent), persistent);
+    }
+
+    Fetch fetch{request};
+    fetch.relay = (options_.relay_mode == RelayMode::Streaming);
+
+    // signed requests are specific to the account, they are never shared
+    if ((request.method == "GET") && (request.target.find("signature=") == std::string::npos))
+        fetch.key = request.method + ' ' + normalize_target(request.target);
+
+    if (!fetch.key.empty() && cache_.enabled())
+    {
+        const auto policy = cache_.policy(target_path(request.target));
+        if (policy.ttl.count() == 0)
+        {
+            gl_stats.cache_bypassed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (auto lookup = cache_.find(fetch.key); !lookup.response)
+        {
+            gl_stats.cache_misses.fetch_add(1, std::memory_order_relaxed);
+            fetch.cache_policy = policy;
+        }
+        else
+        {
+            gl_stats.cache_hits.fetch_add(1, std::memory_order_relaxed);
+            gl_logger->debug("CoroutineHTTPSession, cached response: {}, id: {}", request.target, id_);
+
+            if (lookup.freshness != ResponseCache::Freshness::Fresh)
+            {
+                if (lookup.freshness == ResponseCache::Freshness::Stale)
+                    gl_stats.cache_stale_hits.fetch_add(1, std::memory_order_relaxed);
+                else
+                    gl_stats.cache_refreshes_ahead.fetch_add(1, std::memory_order_relaxed);
+
+                // renewed in the background, the fetch leads the flight of the key
+                if (coalescer_.lead(fetch.key))
+                    asio::co_spawn(executor_, refresh(shared_from_this(), request, fetch.key, policy),
+                                   asio::detached);
+            }
+            co_return co_await send(std::move(lookup.response), persistent);
+        }
+    }
+
+    // identical in-flight requests share the response fetched by the first one
+    if (!fetch.key.empty() && options_.coalescing)
+    {
+        auto waiter = std::make_shared<FlightWaiter>(executor_);
+        const bool leader = coalescer_.join(
+            fetch.key, [waiter](SharedBufferChain response, bool persistent)
+            {
+                // called on the leader's executor
+                asio::post(waiter->signal.get_executor(), [waiter, response, persistent]()
+                           {
+                               waiter->response = response;
+                               waiter->persistent = persistent;
+                               waiter->signal.cancel();
+                           });
+            });
+
+        if (leader)
+        {
+            gl_stats.coalescing_leaders.fetch_add(1, std::memory_order_relaxed);
+            fetch.flight = true;
+        }
+        else
+        {
+            gl_stats.coalescing_followers.fetch_add(1, std::memory_order_relaxed);
+            gl_stats.coalescing_hits.add(target_path(request.target));
+            gl_logger->debug("CoroutineHTTPSession, request coalesced: {}, id: {}", request.target, id_);
+
+            asio::error_code ec_formal;
+            co_await waiter->signal.async_wait(asio::redirect_error(asio::use_awaitable, ec_formal));
+
+            if (!waiter->response)
+                co_return co_await send(bad_gateway(persistent), persistent);
+            co_return co_await send(waiter->response, persistent && waiter->persistent);
+        }
+    }
+
+    const bool relay = fetch.relay;
+    FetchResult result = co_await this->fetch(std::move(fetch));
+    if (!result.succeeded)
+    {
+        // a partially relayed response can't be completed
+        if (result.relay_started)
+            co_return false;
+        co_return co_await send(bad_gateway(persistent), persistent);
+    }
+
+    gl_logger->info("CoroutineHTTPSession, response completed, id: {}", id_);
+
+    persistent = persistent && result.persistent;
+    if (relay)
+        co_return persistent;
+    co_return co_await send(std::move(result.response), persistent);
+}
+
+asio::awaitable<bool> CoroutineHTTPSession::send(SharedBufferChain response, bool persistent)
+{
+    if (closed_)
+        co_return false;
+
+    // the chain is kept alive by the coroutine frame, its blocks are written without copying
+    asio::error_code ec;
+    co_await asio::async_write(stream_, response->buffers(), asio::redirect_error(asio::use_awaitable, ec));
+    co_return !ec && persistent;
+}
+
+// fetches the response upstream, relayed to the client as it arrives if requested
+asio::awaitable<CoroutineHTTPSession::FetchResult> CoroutineHTTPSession::fetch(Fetch fetch)
+{
+    // waiters must not outlive a leader that has given up, the frame may be destroyed while suspended
+    struct FlightGuard
+    {
+        CoroutineHTTPSession& session;
+        Fetch& fetch;
+        ~FlightGuard() { session.share_response(fetch, nullptr, true, 0, {}); }
+    } flight_guard{*this, fetch};
+
+    gl_logger->info("CoroutineHTTPSession, upstream request, id: {}", id_);
+
+    FetchResult result;
+    const auto started_at = std::chrono::steady_clock::now();
+    const std::string request = format_upstream_request(fetch.request, UpstreamPool::HOST);
+    // the response is kept complete to be shared
+    const bool recorded = fetch.flight || (fetch.cache_policy.ttl.count() > 0);
+    auto response = std::make_shared<BufferChain>();
+    std::array<char, buffer_size> chunk;
+
+    HttpResponseFramer framer;
+    UpstreamPool::ConnectionPtr connection;
+    size_t received = 0;
+    bool completed = false;
+    asio::error_code ec;
+
+    // an idle keep-alive connection may have been closed by the upstream in the meantime,
+    // the request is repeated once over a new connection if nothing has been received yet
+    for (bool retried = false;; retried = true)
+    {
+        connection = co_await acquire(!retried, ec);
+        if (ec)
+            break;
+
+        gl_logger->info("CoroutineHTTPSession connected, id: {}, upstream connection: {}, reused: {}",
+                        id_, connection->id, connection->reuse_count);
+
+        co_await asio::async_write(connection->stream, asio::buffer(request),
+                                   asio::redirect_error(asio::use_awaitable, ec));
+
+        while (!ec && !completed)
+        {
+            const asio::mutable_buffer buffer = fetch.relay ? asio::buffer(chunk) : response->prepare();
+            const size_t n = co_await connection->stream.async_read_some(
+                buffer, asio::redirect_error(asio::use_awaitable, ec));
+
+            size_t consumed = 0;
+            bool reusable = false;
+            if (!ec)
+            {
+                consumed = framer.feed(static_cast<const char*>(buffer.data()), n);
+                received += consumed;
+
+                if (framer.failed())
+                {
+                    gl_logger->error("CoroutineHTTPSession, malformed upstream response, id: {}", id_);
+                    break;
+                }
+                completed = framer.complete();
+                reusable = (consumed == n);
+            }
+            else if (is_eof(ec) && framer.reads_until_close())
+            {
+                ec = {};
+                completed = true;
+            }
+            else
+            {
+                break;
+            }
+
+            if (!fetch.relay)
+                response->commit(consumed);
+            else if (recorded)
+                response->append(chunk.data(), consumed); // kept for the cache and coalesced requests
+
+            if (completed)
+            {
+                // a response delimited by the connection close can't be followed by another one
+                result.persistent = !framer.reads_until_close();
+                if (reusable && framer.keep_alive())
+                    upstream_pool_.release(std::move(connection));
+                connection.reset();
+
+                share_response(fetch, response, result.persistent, framer.status_code(), started_at);
+            }
+
+            if (fetch.relay && (consumed > 0))
+            {
+                result.relay_started = true;
+
+                asio::error_code relay_ec;
+                co_await asio::async_write(stream_, asio::buffer(chunk.data(), consumed),
+                                           asio::redirect_error(asio::use_awaitable, relay_ec));
+                if (!check_ec(relay_ec, __func__))
+                {
+                    // the client has gone, the upstream connection can't be reused
+                    close();
+                    if (connection)
+                    {
+                        asio::error_code ec_formal;
+                        connection->stream.lowest_layer().close(ec_formal);
+                    }
+                    co_return result;
+                }
+            }
+        }
+
+        // a malformed response leaves ec clear
+        if (completed || !ec || retried || (connection->reuse_count == 0) || (received > 0))
+            break;
+
+        gl_logger->debug("CoroutineHTTPSession, stale upstream connection {}, retrying, id: {}",
+                         connection->id, id_);
+        framer.reset();
+    }
+
+    if (!completed)
+    {
+        check_ec(ec, __func__);
+
+        gl_stats.upstream_failures.fetch_add(1, std::memory_order_relaxed);
+        share_response(fetch, nullptr, true, 0, started_at);
+
+        if (connection)
+        {
+            asio::error_code ec_formal;
+            connection->stream.lowest_layer().close(ec_formal);
+        }
+        result.relay_started = fetch.relay && (received > 0);
+        co_return result;
+    }
+
+    result.succeeded = true;
+    result.response = std::move(response);
+    co_return result;
+}
+
+// borrows an upstream connection (reuse) or establishes a new one
+asio::awaitable<UpstreamPool::ConnectionPtr> CoroutineHTTPSession::acquire(bool reuse, asio::error_code& ec)
+{
+    auto token = asio::redirect_error(asio::use_awaitable, ec);
+
+    co_return co_await asio::async_initiate<decltype(token), void(asio::error_code, UpstreamPool::ConnectionPtr)>(
+        [this, reuse](auto handler)
+        {
+            // the pool copies its handlers, the coroutine's one is move-only
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            auto on_connect = asio::bind_executor(
+                executor_, [shared](const asio::error_code& ec, UpstreamPool::ConnectionPtr connection)
+                { (*shared)(ec, std::move(connection)); });
+
+            if (reuse)
+                upstream_pool_.acquire(std::move(on_connect));
+            else
+                upstream_pool_.connect(std::move(on_connect));
+        },
+        token);
+}
+
+// renews a cached response in the background while the current one is still served
+asio::awaitable<void> CoroutineHTTPSession::refresh(std::shared_ptr<CoroutineHTTPSession> self, HttpRequest request,
+                                                    std::string key, ResponseCache::Policy policy)
+{
+    gl_stats.cache_refreshes.fetch_add(1, std::memory_order_relaxed);
+    gl_logger->debug("CoroutineHTTPSession, refreshing cached response: {}, id: {}", request.target, id_);
+
+    Fetch fetch{request, std::move(key), true, policy};
+    co_await this->fetch(std::move(fetch));
+}
+
+// hands the complete response over to the cache and the coalesced requests (response null on failure)
+void CoroutineHTTPSession::share_response(Fetch& fetch, SharedBufferChain response, bool persistent,
+                                          int status_code, std::chrono::steady_clock::time_point started_at)
+{
+    // only complete, self-delimited successful responses are reused later
+    if (response && (fetch.cache_policy.ttl.count() > 0) && persistent &&
+        (status_code == static_cast<int>(HTTPResponseCodes::OK)))
+    {
+        const auto fetch_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started_at);
+        cache_.store(fetch.key, response, fetch.cache_policy, fetch_time);
+    }
+    fetch.cache_policy = {};
+
+    if (!fetch.flight)
+        return;
+
+    coalescer_.complete(fetch.key, response, persistent);
+    fetch.flight = false;
+}
+
+SharedBufferChain CoroutineHTTPSession::local_response(const HttpResponse& response, bool persistent)
+{
+    HttpResponse framed = response;
+    framed.headers.set(HeaderId::Connection, persistent ? "keep-alive" : "close");
+
+    auto chain = std::make_shared<BufferChain>();
+    const std::string content = framed.to_string();
+    chain->append(content.data(), content.size());
+    return chain;
+}
+
+SharedBufferChain CoroutineHTTPSession::bad_gateway(bool persistent)
+{
+    HttpResponse response;
+    response.status_code = static_cast<int>(HTTPResponseCodes::BadGateway);
+    response.reason = "Bad Gateway";
+    response.headers.set(HeaderId::ContentType, "text/plain");
+    response.body = "upstream request failed";
+    return local_response(response, persistent);
+}
+
+void CoroutineHTTPSession::close()
+{
+    closed_ = true;
+    idle_timer_.cancel();
+
+    stream_.shutdown();
+}
+
+#endif // MB_COROUTINES
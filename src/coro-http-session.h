@@ -0,0 +1,104 @@
+#pragma once
+
+#ifdef MB_COROUTINES
+
+#include <asio.hpp>
+#include <asio/any_io_executor.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "client-stream.h"
+#include "common/session.h"
+#include "upstream-pool.h"
+#include "utils/buffer-chain.h"
+#include "utils/http-helper.h"
+#include "utils/http-request-parser.h"
+#include "utils/request-coalescer.h"
+#include "utils/response-cache.h"
+#include "utils/session-registry.h"
+
+// Coroutine counterpart of HTTPSession (--session-engine coroutine, MB_COROUTINES builds).
+// A single coroutine per client connection reads a request, answers it (locally,
+// from the cache, from an identical request in flight or from the upstream) and
+// loops while the connection is kept alive. The state of an exchange lives in the
+// coroutine frame instead of the shared_ptr captured by each chained handler.
+// Pipelined requests are answered one after the other, the callback engine
+// fetches them concurrently.
+class CoroutineHTTPSession : public Session,
+                             public std::enable_shared_from_this<CoroutineHTTPSession>
+{
+    constexpr static size_t buffer_size = 4096;
+
+    // upstream request of an exchange
+    struct Fetch
+    {
+        const HttpRequest& request;
+        std::string key;                    // normalized method and target of a shareable request
+        bool flight = false;                // leads a coalesced fetch
+        ResponseCache::Policy cache_policy; // the response is cached if the TTL is set
+        bool relay = false;                 // sent to the client while being received
+    };
+
+    struct FetchResult
+    {
+        bool succeeded = false;
+        bool persistent = true;     // the client connection may carry further exchanges
+        bool relay_started = false; // part of the response has already gone to the client
+        SharedBufferChain response; // complete response, unless relayed without being recorded
+    };
+
+public:
+    // executor: serializes the session (a strand unless the io_context is single-threaded)
+    CoroutineHTTPSession(asio::io_context& io, ClientStream&& stream, asio::any_io_executor executor, uint64_t id,
+                         UpstreamPool& upstream_pool, RequestCoalescer& coalescer, ResponseCache& cache,
+                         const SessionOptions& options);
+    ~CoroutineHTTPSession() override;
+
+    void start() override;
+    // starts the session listed in a registry until destroyed
+    void start(SessionRegistry::Registration registration);
+    void stop() override;
+    uint64_t get_id() override
+    {
+        return id_;
+    }
+
+private:
+    asio::awaitable<void> serve(std::shared_ptr<CoroutineHTTPSession> self);
+    asio::awaitable<bool> respond(const HttpRequest& request, bool persistent);
+    asio::awaitable<bool> send(SharedBufferChain response, bool persistent);
+    asio::awaitable<FetchResult> fetch(Fetch fetch);
+    asio::awaitable<UpstreamPool::ConnectionPtr> acquire(bool reuse, asio::error_code& ec);
+    asio::awaitable<void> refresh(std::shared_ptr<CoroutineHTTPSession> self, HttpRequest request,
+                                  std::string key, ResponseCache::Policy policy);
+    void share_response(Fetch& fetch, SharedBufferChain response, bool persistent, int status_code,
+                        std::chrono::steady_clock::time_point started_at);
+    SharedBufferChain local_response(const HttpResponse& response, bool persistent);
+    SharedBufferChain bad_gateway(bool persistent);
+    HttpRequestParser::Status parse_buffered();
+    void arm_idle_timer();
+    void close();
+
+private:
+    asio::io_context& io_;
+    ClientStream stream_; // plain or TLS client connection
+    asio::any_io_executor executor_;
+    asio::steady_timer idle_timer_;
+    asio::streambuf buffer_;
+    HttpRequestParser parser_; // request head being received in buffer_
+    UpstreamPool& upstream_pool_;
+    RequestCoalescer& coalescer_;
+    ResponseCache& cache_;
+    const SessionOptions& options_;
+    SessionRegistry::Registration registration_;
+    uint64_t id_{0};
+    uint64_t requests_ = 0;
+    bool awaiting_request_ = false;
+    bool closed_ = false;
+    bool stopped_ = false;
+};
+
+#endif // MB_COROUTINES
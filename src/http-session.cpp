@@ -4,11 +4,15 @@
 #include <asio/ssl.hpp>
 #include <spdlog/fmt/fmt.h>
 
+#include "common/stats.h"
 #include "logs/logger.h"
 
-HTTPSession::HTTPSession(asio::io_context& io, tcp::socket&& socket, uint64_t id)
-    : io_(io), socket_(std::move(socket)), strand_(asio::make_strand(socket_.get_executor())),
-      tls_context_(asio::ssl::context::tls_client),
+HTTPSession::HTTPSession(asio::io_context& io, ClientStream&& stream, asio::any_io_executor executor, uint64_t id,
+                         UpstreamPool& upstream_pool, RequestCoalescer& coalescer, ResponseCache& cache,
+                         const SessionOptions& options)
+    : io_(io), stream_(std::move(stream)), executor_(std::move(executor)),
+      idle_timer_(executor_), upstream_pool_(upstream_pool), coalescer_(coalescer), cache_(cache),
+      options_(options),
       id_(id)
 {
 
@@ -17,169 +21,513 @@ HTTPSession::HTTPSession(asio::io_context& io, tcp::socket&& socket, uint64_t id
 
 HTTPSession::~HTTPSession()
 {
-    gl_logger->trace("HTTPSession destructed, id: {}", id_);
+    gl_logger->trace("HTTPSession destructed, id: {}, requests: {}", id_, requests_);
+}
+
+void HTTPSession::set_pool_capacity(size_t blocks)
+{
+    RecyclingPool<SessionBlocks>::set_capacity(blocks);
+    RecyclingPool<ExchangeBlocks>::set_capacity(blocks);
+    RecyclingPool<OutgoingBlocks>::set_capacity(blocks);
 }
 
 void HTTPSession::start()
 {
     gl_logger->info("HTTPSession started, id: {} ...", id_);
 
-    if (!init_tls_context())
-    {
-        gl_logger->info("HTTPSession failed, id: {} ...", id_);
-    }
-    else
-    {
-        obtain_header();
-    }
+    gl_stats.client_connections.fetch_add(1, std::memory_order_relaxed);
+
+    obtain_header();
+}
+
+void HTTPSession::start(SessionRegistry::Registration registration)
+{
+    registration_ = std::move(registration);
+    start();
 }
 
 void HTTPSession::stop()
 {
     gl_logger->info("HTTPSession session, stop pending, id: {} ...", id_);
-    stopped_ = true;
+
+    auto self = shared_from_this();
+
+    // an idle keep-alive connection is closed right away,
+    // a busy one once the queued responses have been sent
+    asio::dispatch(bind_with_memory(executor_, handler_memory_,
+                                    [this, self]()
+                                    {
+                                        stopped_ = true;
+                                        if (exchanges_.empty())
+                                            close();
+                                    }));
 }
 
-bool HTTPSession::init_tls_context()
+void HTTPSession::obtain_header()
 {
-    bool result(true);
-    std::string failure_hints;
+    std::shared_ptr<HTTPSession> self = shared_from_this();
 
-    try
+    awaiting_request_ = true;
+    if (exchanges_.empty())
+        arm_idle_timer();
+
+    // a pipelined request may already be in buffer_, the socket isn't touched then
+    if ((buffer_.size() > 0) && (parse_buffered() != HttpRequestParser::Status::Incomplete))
     {
-#ifdef _WIN32
-        const std::string cert_path = "certs\\cacert.pem";
-        failure_hints = fmt::format("(possibly SSL certificate not found ({})", cert_path);
-
-        tls_context_.set_verify_mode(asio::ssl::verify_peer);
-        tls_context_.load_verify_file(cert_path);
-#else
-        // Use system CA certificates (Linux/macOS typically OK)
-        tls_context_.set_default_verify_paths();
-#endif
+        asio::post(bind_with_memory(executor_, handler_memory_,
+                                    [this, self]()
+                                    {
+                                        on_header();
+                                    }));
+        return;
     }
-    catch (const std::exception& e)
+
+    read_header();
+}
+
+// receives until the request head is complete
+void HTTPSession::read_header()
+{
+    std::shared_ptr<HTTPSession> self = shared_from_this();
+
+    stream_.async_read_some(
+        buffer_.prepare(buffer_size),
+        bind_with_memory(executor_, handler_memory_,
+                         [this, self](const asio::error_code& ec, std::size_t bytes_transferred)
+                         {
+                             if (ec)
+                             {
+                                 awaiting_request_ = false;
+                                 idle_timer_.cancel();
+                                 reads_closed_ = true;
+
+                                 // the client closing an idle keep-alive connection is not an error
+                                 if ((requests_ == 0) || !(is_eof(ec) || (ec == asio::error::operation_aborted)))
+                                     check_ec(ec, __func__);
+
+                                 // responses to the requests already received are still sent
+                                 if (exchanges_.empty())
+                                     close();
+                                 return;
+                             }
+
+                             buffer_.commit(bytes_transferred);
+                             if (parse_buffered() == HttpRequestParser::Status::Incomplete)
+                                 read_header();
+                             else
+                                 on_header();
+                         }));
+}
+
+// parses the received bytes in place, resuming where the previous call stopped
+HttpRequestParser::Status HTTPSession::parse_buffered()
+{
+    const auto data = buffer_.data();
+    return parser_.parse(std::string_view(static_cast<const char*>(data.data()), data.size()));
+}
+
+void HTTPSession::on_header()
+{
+    awaiting_request_ = false;
+    idle_timer_.cancel();
+
+    if (parser_.status() == HttpRequestParser::Status::Error)
     {
-        gl_logger->error("TLS initialization failure {} {}", e.what(), failure_hints);
-        result = false;
+        gl_logger->debug("HTTPSession, malformed request, id: {}", id_);
+        reject_request();
+        return;
     }
 
-    return result;
+    // the exchange outlives the receive buffer, the request owns its parts
+    HttpRequest request = make_request(parser_);
+    buffer_.consume(parser_.size());
+    parser_.reset();
+
+    on_request(std::move(request));
 }
 
-void HTTPSession::obtain_header()
+// answers a malformed request and closes the connection once the queued responses have been sent
+void HTTPSession::reject_request()
 {
-    std::shared_ptr<HTTPSession> self = shared_from_this();
+    reads_closed_ = true;
+
+    auto exchange = std::allocate_shared<Exchange>(RecyclingAllocator<Exchange, ExchangeBlocks>());
+    exchange->persistent = false;
+    exchanges_.push_back(exchange);
+
+    HttpResponse response;
+    response.status_code = static_cast<int>(HTTPResponseCodes::BadRequest);
+    response.reason = "Bad Request";
+    response.headers.set(HeaderId::ContentType, "text/plain");
+    response.body = "malformed request";
+
+    complete_locally(exchange, response);
+    send_pending();
+}
 
-    asio::async_read_until(
-        socket_, buffer_, http_request_headers_delimiter,
-        asio::bind_executor(strand_,
-                            [this, self](const asio::error_code& ec, std::size_t bytes_transferred)
-                            {
-                                if (check_ec(ec, __func__))
-                                {
-                                    std::istream stream(&buffer_);
-                                    raw_request_.resize(bytes_transferred);
-                                    stream.read(&raw_request_[0], bytes_transferred);
+void HTTPSession::arm_idle_timer()
+{
+    if (options_.keep_alive_timeout.count() == 0)
+        return;
+
+    std::shared_ptr<HTTPSession> self = shared_from_this();
 
-                                    HttpRequest request = parse_request(raw_request_);
-                                    on_request(request);
-                                }
-                            }));
+    idle_timer_.expires_after(options_.keep_alive_timeout);
+    idle_timer_.async_wait(bind_with_memory(executor_, handler_memory_,
+                                            [this, self](const asio::error_code& ec)
+                                            {
+                                                if (ec != asio::error::operation_aborted)
+                                                {
+                                                    gl_logger->debug("HTTPSession idle timeout, id: {}", id_);
+                                                    close();
+                                                }
+                                            }));
 }
 
 void HTTPSession::on_request(HttpRequest request)
 {
     if (stopped_)
+    {
+        reads_closed_ = true;
+        if (exchanges_.empty())
+            close();
         return;
+    }
 
     std::shared_ptr<HTTPSession> self = shared_from_this();
-    request_ = std::move(request);
+    requests_++;
 
-    auto outgoing_session = std::make_shared<HTTPSession::OutgoingSession>(self);
-    outgoing_session->start();
+    auto exchange = std::allocate_shared<Exchange>(RecyclingAllocator<Exchange, ExchangeBlocks>());
+    exchange->request = std::move(request);
+    exchange->persistent = (options_.keep_alive_timeout.count() > 0) && is_keep_alive(exchange->request) &&
+                           allows_next_request(exchange->request);
+    // only the response at the head of the queue can go to the client as it arrives
+    exchange->streaming = exchanges_.empty() && (options_.relay_mode == RelayMode::Streaming);
+
+    gl_stats.client_requests.fetch_add(1, std::memory_order_relaxed);
+    if (!exchanges_.empty())
+        gl_stats.client_pipelined_requests.fetch_add(1, std::memory_order_relaxed);
+
+    exchanges_.push_back(exchange);
+
+    if (exchange->request.target == stats_target)
+    {
+        HttpResponse response;
+        response.headers.set(HeaderId::ContentType, "application/json");
+        response.body = gl_stats.to_json();
+        complete_locally(exchange, response);
+    }
+    else
+    {
+        // signed requests are specific to the account, they are never shared
+        const std::string& target = exchange->request.target;
+        if ((exchange->request.method == "GET") && (target.find("signature=") == std::string::npos))
+            exchange->key = exchange->request.method + ' ' + normalize_target(target);
+
+        // answered from the cache, by an identical request in flight or fetched upstream
+        if (!serve_cached(exchange) && !join_flight(exchange))
+        {
+            auto outgoing_session = std::allocate_shared<HTTPSession::OutgoingSession>(
+                RecyclingAllocator<OutgoingSession, OutgoingBlocks>(), self, exchange);
+            outgoing_session->start();
+        }
+    }
+
+    // read ahead: the next request is fetched while the previous responses are pending
+    if (!exchange->persistent)
+        reads_closed_ = true;
+    else if (!awaiting_request_ && can_read_ahead())
+        obtain_header();
+
+    send_pending();
 }
 
-void HTTPSession::on_outgoing_session_completed(const asio::error_code& ec, std::string response)
+// returns true if the exchange has been answered from the response cache
+bool HTTPSession::serve_cached(const ExchangePtr& exchange)
 {
-    gl_logger->info("OutgoingSession completed, id: {}", id_);
-    gl_logger->trace("Response {}", response);
+    if (exchange->key.empty() || !cache_.enabled())
+        return false;
+
+    const auto policy = cache_.policy(target_path(exchange->request.target));
+    if (policy.ttl.count() == 0)
+    {
+        gl_stats.cache_bypassed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto lookup = cache_.find(exchange->key);
+    if (!lookup.response)
+    {
+        gl_stats.cache_misses.fetch_add(1, std::memory_order_relaxed);
+        exchange->cache_policy = policy;
+        return false;
+    }
+
+    gl_stats.cache_hits.fetch_add(1, std::memory_order_relaxed);
+    gl_logger->debug("HTTPSession, cached response: {}, id: {}", exchange->request.target, id_);
+
+    if (lookup.freshness == ResponseCache::Freshness::Stale)
+    {
+        gl_stats.cache_stale_hits.fetch_add(1, std::memory_order_relaxed);
+        refresh(exchange, policy);
+    }
+    else if (lookup.freshness == ResponseCache::Freshness::RefreshDue)
+    {
+        gl_stats.cache_refreshes_ahead.fetch_add(1, std::memory_order_relaxed);
+        refresh(exchange, policy);
+    }
+
+    exchange->response = std::move(lookup.response);
+    exchange->streaming = false;
+    exchange->completed = true;
+    return true;
+}
+
+// renews a cached response in the background while the current one is still served,
+// the fetch leads the flight of the key, so it's started once and joined by the cache misses
+void HTTPSession::refresh(const ExchangePtr& exchange, const ResponseCache::Policy& policy)
+{
+    if (!coalescer_.lead(exchange->key))
+        return; // already being fetched
+
+    gl_stats.cache_refreshes.fetch_add(1, std::memory_order_relaxed);
+    gl_logger->debug("HTTPSession, refreshing cached response: {}, id: {}", exchange->request.target, id_);
+
+    // not queued: its completion isn't sent to the client
+    auto background = std::allocate_shared<Exchange>(RecyclingAllocator<Exchange, ExchangeBlocks>());
+    background->request = exchange->request;
+    background->key = exchange->key;
+    background->flight = true;
+    background->cache_policy = policy;
+
+    std::allocate_shared<HTTPSession::OutgoingSession>(RecyclingAllocator<OutgoingSession, OutgoingBlocks>(),
+                                                       shared_from_this(), background)
+        ->start();
+}
+
+// identical in-flight requests share the response fetched by the first one,
+// returns true if the exchange waits for another session's fetch
+bool HTTPSession::join_flight(const ExchangePtr& exchange)
+{
+    const HttpRequest& request = exchange->request;
 
-    response_ = std::move(response);
+    if (exchange->key.empty() || !options_.coalescing)
+        return false;
 
     auto self = shared_from_this();
+    const bool leader = coalescer_.join(
+        exchange->key, [this, self, exchange](SharedBufferChain response, bool persistent)
+        {
+            // called on the leader's executor
+            asio::post(bind_with_memory(executor_, handler_memory_,
+                                        [this, self, exchange, response, persistent]()
+                                        {
+                                            if (response)
+                                                on_outgoing_session_completed(exchange, response, persistent);
+                                            else
+                                                on_outgoing_session_failed(exchange, false);
+                                        }));
+        });
+
+    if (leader)
+    {
+        gl_stats.coalescing_leaders.fetch_add(1, std::memory_order_relaxed);
+        exchange->flight = true;
+        return false;
+    }
 
-    auto buff = asio::buffer(response_);
-    asio::async_write(
-        socket_, buff,
-        asio::bind_executor(strand_,
-                            [this, self](const asio::error_code& ec, std::size_t)
-                            {
-                                asio::error_code ec_formal;
-                                auto rc = socket_.shutdown(tcp::socket::shutdown_both, ec_formal);
-                            }));
-};
+    gl_stats.coalescing_followers.fetch_add(1, std::memory_order_relaxed);
+    gl_stats.coalescing_hits.add(target_path(request.target));
+    gl_logger->debug("HTTPSession, request coalesced: {}, id: {}", request.target, id_);
 
-HTTPSession::OutgoingSession::~OutgoingSession()
+    // the shared response is sent once complete
+    exchange->streaming = false;
+    return true;
+}
+
+void HTTPSession::on_outgoing_session_completed(const ExchangePtr& exchange, SharedBufferChain response,
+                                               bool persistent)
 {
-    gl_logger->trace("OutgoingSession destructed id: {}...", context_.session_id);
+    gl_logger->info("OutgoingSession completed, id: {}", id_);
+    if (gl_logger->should_log(spdlog::level::trace))
+        gl_logger->trace("Response {}", response->to_string());
+
+    exchange->response = std::move(response);
+    exchange->persistent = exchange->persistent && persistent;
+    exchange->completed = true;
+    send_pending();
 }
 
-void HTTPSession::OutgoingSession::start()
+void HTTPSession::on_outgoing_session_failed(const ExchangePtr& exchange, bool relay_started)
 {
-    if (!init_ssl())
+    if (relay_started)
     {
-        gl_logger->error("SSL initialization failure!");
+        // a partially relayed response can't be completed
+        close();
         return;
     }
 
-    gl_logger->info("OutgoingSession started, id: {}", context_.session_id);
+    HttpResponse response;
+    response.status_code = static_cast<int>(HTTPResponseCodes::BadGateway);
+    response.reason = "Bad Gateway";
+    response.headers.set(HeaderId::ContentType, "text/plain");
+    response.body = "upstream request failed";
+
+    complete_locally(exchange, response);
+    send_pending();
+}
+
+void HTTPSession::complete_locally(const ExchangePtr& exchange, const HttpResponse& response)
+{
+    HttpResponse framed = response;
+    framed.headers.set(HeaderId::Connection, exchange->persistent ? "keep-alive" : "close");
+
+    auto chain = std::make_shared<BufferChain>();
+    const std::string content = framed.to_string();
+    chain->append(content.data(), content.size());
+
+    exchange->response = std::move(chain);
+    exchange->streaming = false;
+    exchange->completed = true;
+}
+
+// writes the response at the head of the queue once it is available
+void HTTPSession::send_pending()
+{
+    if (writing_ || closed_ || exchanges_.empty())
+        return;
+
+    const ExchangePtr& head = exchanges_.front();
+    if (head->streaming || !head->completed)
+        return;
+
+    writing_ = true;
 
     auto self = shared_from_this();
+    auto response = head->response;
 
-    resolver_.async_resolve(HOST, PORT,
-                            asio::bind_executor(context_.strand,
-                                                [this, self](const asio::error_code& ec,
-                                                             tcp::resolver::results_type results)
-                                                {
-                                                    if (check_ec(ec, __func__))
-                                                    {
-                                                        connect(results);
-                                                    }
-                                                }));
+    // the chain is kept alive by the handler, its blocks are written without copying
+    asio::async_write(
+        stream_, response->buffers(),
+        bind_with_memory(executor_, handler_memory_,
+                         [this, self, response](const asio::error_code& ec, std::size_t)
+                         {
+                             writing_ = false;
+                             on_response_sent(ec);
+                         }));
 }
 
-void HTTPSession::OutgoingSession::connect(const tcp::resolver::results_type& endpoints)
+// writes a chunk of the response being relayed, the outgoing session is notified once it's done
+void HTTPSession::write_response_part(asio::const_buffer buffer, std::shared_ptr<OutgoingSession> relay)
 {
     auto self = shared_from_this();
 
-    asio::async_connect(
-        stream_.next_layer(), endpoints,
-        asio::bind_executor(context_.strand,
-                            [this, self](const asio::error_code& ec, const tcp::endpoint&)
-                            {
-                                if (check_ec(ec, __func__))
-                                {
-                                    on_connect();
-                                }
-                            }));
-};
+    asio::async_write(
+        stream_, buffer,
+        bind_with_memory(executor_, handler_memory_,
+                         [this, self, relay = std::move(relay)](const asio::error_code& ec, std::size_t)
+                         {
+                             if (ec)
+                                 close();
+                             relay->on_relayed(ec);
+                         }));
+}
+
+void HTTPSession::on_response_relayed(bool persistent)
+{
+    gl_logger->info("OutgoingSession completed, id: {}", id_);
+
+    exchanges_.front()->persistent = exchanges_.front()->persistent && persistent;
+    on_response_sent({});
+}
+
+void HTTPSession::on_response_sent(const asio::error_code& ec)
+{
+    const bool persistent = exchanges_.front()->persistent;
+    exchanges_.pop_front();
+
+    if (ec || !persistent)
+    {
+        // responses queued behind a closing one are dropped
+        close();
+        return;
+    }
+
+    if (!exchanges_.empty())
+    {
+        // the response of the next request may already be waiting
+        send_pending();
+    }
+    else if (stopped_ || reads_closed_)
+    {
+        close();
+        return;
+    }
+    else if (awaiting_request_)
+    {
+        arm_idle_timer();
+    }
+
+    if (!awaiting_request_ && !reads_closed_ && !stopped_ && can_read_ahead())
+        obtain_header();
+}
+
+// the next request is read while responses are pending only behind bodiless GETs:
+// anything else (a method upstream answers as a GET, a body) is completed before reading on
+bool HTTPSession::can_read_ahead() const
+{
+    return (exchanges_.size() < max_pipelined_requests) &&
+           (exchanges_.empty() || (exchanges_.back()->request.method == "GET"));
+}
+
+void HTTPSession::close()
+{
+    closed_ = true;
+    reads_closed_ = true;
+    idle_timer_.cancel();
+
+    stream_.shutdown();
+}
+
+HTTPSession::OutgoingSession::~OutgoingSession()
+{
+    // waiters must not outlive a leader that has given up
+    share_response(false);
+
+    gl_logger->trace("OutgoingSession destructed id: {}...", context_.session_id);
+}
 
-void HTTPSession::OutgoingSession::on_connect()
+void HTTPSession::OutgoingSession::start()
 {
-    gl_logger->info("OutgoingSession connected, id: {}", context_.session_id);
+    gl_logger->info("OutgoingSession started, id: {}", context_.session_id);
+
+    started_at_ = std::chrono::steady_clock::now();
 
     auto self = shared_from_this();
 
-    stream_.async_handshake(asio::ssl::stream_base::client,
-                            asio::bind_executor(context_.strand,
-                                                [this, self](const asio::error_code& ec)
-                                                {
-                                                    if (check_ec(ec, __func__))
-                                                    {
-                                                        send_request();
-                                                    }
-                                                }));
+    context_.upstream_pool.acquire(
+        bind_with_memory(context_.executor, handler_memory_,
+                         [this, self](const asio::error_code& ec,
+                                      UpstreamPool::ConnectionPtr connection)
+                         {
+                             on_connect(ec, std::move(connection));
+                         }));
+}
+
+void HTTPSession::OutgoingSession::on_connect(const asio::error_code& ec,
+                                              UpstreamPool::ConnectionPtr connection)
+{
+    if (!check_ec(ec, __func__))
+    {
+        fail();
+        return;
+    }
+
+    gl_logger->info("OutgoingSession connected, id: {}, upstream connection: {}, reused: {}",
+                    context_.session_id, connection->id, connection->reuse_count);
+
+    connection_ = std::move(connection);
+    send_request();
 }
 
 void HTTPSession::OutgoingSession::send_request()
@@ -188,70 +536,220 @@ void HTTPSession::OutgoingSession::send_request()
 
     generate_request();
 
-    asio::async_write(stream_, asio::buffer(http_request_),
-                      asio::bind_executor(context_.strand,
-                                          [this, self](const asio::error_code& ec, std::size_t)
-                                          {
-                                              if (check_ec(ec, __func__))
-                                              {
-                                                  read_response();
-                                              }
-                                          }));
+    asio::async_write(connection_->stream, asio::buffer(http_request_),
+                      bind_with_memory(context_.executor, handler_memory_,
+                                       [this, self](const asio::error_code& ec, std::size_t)
+                                       {
+                                           if (ec && retry_on_fresh_connection())
+                                               return;
+                                           if (check_ec(ec, __func__))
+                                               read_response();
+                                           else
+                                               fail();
+                                       }));
 }
 
 void HTTPSession::OutgoingSession::read_response()
 {
     auto self = shared_from_this();
 
-    stream_.async_read_some(
-        asio::buffer(buffer_),
-        asio::bind_executor(
-            context_.strand,
-            [this, self](const asio::error_code& ec, std::size_t n)
-            {
-                if (is_eof(ec))
-                {
-                    std::string resp(response_.str());
-                    outer_session_->on_outgoing_session_completed(ec, std::move(resp));
-                }
-                else if (check_ec(ec, __func__))
-                {
-                    response_.write(buffer_.data(), static_cast<std::streamsize>(n));
-                    read_response(); // continue reading
-                }
-            }));
+    // buffered mode reads straight into the response chain
+    read_buffer_ = !exchange_->streaming
+                       ? response_->prepare()
+                       : asio::buffer(buffers_[read_slot_]);
+
+    reading_ = true;
+    connection_->stream.async_read_some(
+        read_buffer_,
+        bind_with_memory(context_.executor, handler_memory_,
+                         [this, self](const asio::error_code& ec, std::size_t n)
+                         {
+                             reading_ = false;
+                             on_read(ec, n);
+                         }));
 }
 
-void HTTPSession::OutgoingSession::generate_request()
+void HTTPSession::OutgoingSession::on_read(const asio::error_code& ec, std::size_t n)
 {
-    std::string user_agent;
-    auto it = context_.request.headers.find("User-Agent");
-    if (it != context_.request.headers.end())
-        user_agent = it->second;
-    else
-        user_agent = "market-bridge/1.0.0";
+    if (relay_failed_)
+        return;
 
-    http_request_ = fmt::format("GET {} "
-                                "HTTP/1.1\r\n"
-                                "Host: {}\r\n"
-                                "User-Agent: {}\r\n"
-                                "Accept: */*\r\n"
-                                "Connection: close\r\n"
-                                "\r\n",
-                                context_.request.target, HOST, user_agent);
+    if (!ec)
+    {
+        const size_t consumed = framer_.feed(static_cast<const char*>(read_buffer_.data()), n);
+        received_ += consumed;
+
+        if (framer_.failed())
+        {
+            gl_logger->error("OutgoingSession, malformed upstream response, id: {}",
+                             context_.session_id);
+            fail();
+            return;
+        }
+        if (framer_.complete())
+            on_upstream_completed(consumed == n);
+
+        deliver(read_slot_, consumed);
+    }
+    else if (is_eof(ec) && framer_.reads_until_close())
+    {
+        on_upstream_completed(false);
+        deliver(read_slot_, 0);
+    }
+    else if (!retry_on_fresh_connection())
+    {
+        check_ec(ec, __func__);
+        fail();
+    }
 }
 
-bool HTTPSession::OutgoingSession::init_ssl()
+void HTTPSession::OutgoingSession::on_upstream_completed(bool reusable)
 {
-    // Verify server certificate (important)
-    stream_.set_verify_mode(asio::ssl::verify_peer);
-    stream_.set_verify_callback(asio::ssl::host_name_verification(HOST));
+    upstream_completed_ = true;
+    // a response delimited by the connection close can't be followed by another one
+    persistent_ = !framer_.reads_until_close();
+
+    if (reusable && framer_.keep_alive())
+        context_.upstream_pool.release(std::move(connection_));
+    connection_.reset();
+}
 
-    // SNI (many hosts require it)
-    bool result = SSL_set_tlsext_host_name(stream_.native_handle(), HOST.c_str());
-    if (!result)
+void HTTPSession::OutgoingSession::deliver(size_t slot, size_t size)
+{
+    if (!exchange_->streaming)
+        response_->commit(size);
+    else if (exchange_->recorded())
+        response_->append(buffers_[slot].data(), size); // kept for the cache and coalesced requests
+
+    if (upstream_completed_)
+        share_response(true);
+
+    if (!exchange_->streaming)
+    {
+        if (!upstream_completed_)
+            read_response(); // continue reading
+        else
+            outer_session_->on_outgoing_session_completed(exchange_, std::move(response_), persistent_);
+        return;
+    }
+
+    if (relaying_)
+    {
+        // both buffers are busy, reading resumes once the client has caught up
+        pending_chunk_.emplace(slot, size);
+        return;
+    }
+
+    relay(slot, size);
+}
+
+void HTTPSession::OutgoingSession::relay(size_t slot, size_t size)
+{
+    // the other buffer is free while this one is being written
+    read_slot_ = slot ^ 1;
+
+    if (size > 0)
+    {
+        relaying_ = true;
+
+        outer_session_->write_response_part(asio::buffer(buffers_[slot].data(), size), shared_from_this());
+    }
+
+    if (!upstream_completed_ && !reading_)
+        read_response();
+    else if (upstream_completed_ && !relaying_)
+        outer_session_->on_response_relayed(persistent_);
+}
+
+void HTTPSession::OutgoingSession::on_relayed(const asio::error_code& ec)
+{
+    relaying_ = false;
+
+    if (!check_ec(ec, __func__))
     {
-        gl_logger->error("Failed to set SNI host name {}", HOST);
+        // the client has gone, the upstream connection can't be reused
+        relay_failed_ = true;
+        if (connection_)
+        {
+            asio::error_code ec_formal;
+            connection_->stream.lowest_layer().close(ec_formal);
+        }
+        return;
     }
-    return result;
+
+    if (pending_chunk_)
+    {
+        auto [slot, size] = *pending_chunk_;
+        pending_chunk_.reset();
+        relay(slot, size);
+    }
+    else if (upstream_completed_)
+    {
+        outer_session_->on_response_relayed(persistent_);
+    }
+}
+
+// an idle keep-alive connection may have been closed by the upstream in the meantime,
+// the request is repeated once over a new connection if nothing has been received yet
+bool HTTPSession::OutgoingSession::retry_on_fresh_connection()
+{
+    if (retried_ || !connection_ || (connection_->reuse_count == 0) || (received_ > 0))
+        return false;
+
+    gl_logger->debug("OutgoingSession, stale upstream connection {}, retrying, id: {}",
+                     connection_->id, context_.session_id);
+
+    retried_ = true;
+    connection_.reset();
+    framer_.reset();
+
+    auto self = shared_from_this();
+
+    context_.upstream_pool.connect(
+        bind_with_memory(context_.executor, handler_memory_,
+                         [this, self](const asio::error_code& ec,
+                                      UpstreamPool::ConnectionPtr connection)
+                         {
+                             on_connect(ec, std::move(connection));
+                         }));
+    return true;
+}
+
+// hands the complete response over to the cache and the coalesced requests
+void HTTPSession::OutgoingSession::share_response(bool succeeded)
+{
+    // only complete, self-delimited successful responses are reused later
+    if (succeeded && (exchange_->cache_policy.ttl.count() > 0) && persistent_ &&
+        (framer_.status_code() == static_cast<int>(HTTPResponseCodes::OK)))
+    {
+        const auto fetch_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started_at_);
+        context_.cache.store(exchange_->key, response_, exchange_->cache_policy, fetch_time);
+    }
+    exchange_->cache_policy = {};
+
+    if (!exchange_->flight)
+        return;
+
+    context_.coalescer.complete(exchange_->key, succeeded ? response_ : nullptr, persistent_);
+    exchange_->flight = false;
+}
+
+void HTTPSession::OutgoingSession::fail()
+{
+    gl_stats.upstream_failures.fetch_add(1, std::memory_order_relaxed);
+    share_response(false);
+
+    if (connection_)
+    {
+        asio::error_code ec_formal;
+        connection_->stream.lowest_layer().close(ec_formal);
+        connection_.reset();
+    }
+    outer_session_->on_outgoing_session_failed(exchange_, exchange_->streaming && (received_ > 0));
+}
+
+void HTTPSession::OutgoingSession::generate_request()
+{
+    http_request_ = format_upstream_request(exchange_->request, UpstreamPool::HOST);
 }
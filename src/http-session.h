@@ -1,12 +1,26 @@
 #pragma once
 
+#include "client-stream.h"
 #include "common/ec-handler.h"
+#include "upstream-pool.h"
+#include "utils/buffer-chain.h"
+#include "utils/handler-memory.h"
 #include "utils/http-helper.h"
+#include "utils/http-request-parser.h"
+#include "utils/http-response-framer.h"
+#include "utils/recycling-pool.h"
+#include "utils/request-coalescer.h"
+#include "utils/response-cache.h"
+#include "utils/session-registry.h"
 #include <asio.hpp>
 #include <asio/any_io_executor.hpp>
 #include <asio/io_context.hpp>
 #include <asio/ssl.hpp>
+#include <asio/steady_timer.hpp>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <string>
 
@@ -18,26 +32,47 @@ class HTTPSession : public Session,
                     public std::enable_shared_from_this<HTTPSession>
 {
     constexpr static size_t buffer_size = 4096;
+    // requests read ahead of the response being sent
+    constexpr static size_t max_pipelined_requests = 16;
 
     struct Context
     {
         asio::io_context& io;
-        asio::strand<asio::any_io_executor>& strand;
-        asio::ssl::context& tls_context;
-        const HttpRequest& request;
+        asio::any_io_executor& executor;
+        UpstreamPool& upstream_pool;
+        RequestCoalescer& coalescer;
+        ResponseCache& cache;
+        const SessionOptions& options;
         const uint64_t& session_id;
     };
 
+    // a request and its response; pipelined exchanges are fetched concurrently,
+    // their responses are sent back in the order the requests were received
+    struct Exchange
+    {
+        HttpRequest request;
+        bool streaming = false;  // relayed to the client while being received (head of the queue only)
+        bool completed = false;  // the buffered response is ready to be sent
+        bool persistent = true;  // the connection may carry further exchanges
+        SharedBufferChain response;
+        std::string key;         // normalized method and target of a shareable request
+        bool flight = false;     // leads a coalesced fetch
+        ResponseCache::Policy cache_policy; // the fetched response is cached if the TTL is set
+
+        // the response is kept complete to be shared
+        bool recorded() const { return flight || (cache_policy.ttl.count() > 0); }
+    };
+    using ExchangePtr = std::shared_ptr<Exchange>;
+
     class OutgoingSession : public Session,
                             public std::enable_shared_from_this<OutgoingSession>
     {
-        inline static const std::string HOST = "api.binance.com";
-        inline static const std::string PORT = "443";
+        friend class HTTPSession; // completes the relayed writes
 
     public:
-        OutgoingSession(std::shared_ptr<HTTPSession> outer_session)
+        OutgoingSession(std::shared_ptr<HTTPSession> outer_session, ExchangePtr exchange)
             : outer_session_(outer_session), context_(outer_session->get_context()),
-              resolver_(context_.io), stream_(context_.io, context_.tls_context) {}
+              exchange_(std::move(exchange)) {}
         ~OutgoingSession();
 
         void start() override;
@@ -48,30 +83,76 @@ class HTTPSession : public Session,
         }
 
     protected:
-        void on_connect();
+        void on_connect(const asio::error_code& ec, UpstreamPool::ConnectionPtr connection);
 
     private:
-        bool init_ssl();
-        void connect(const tcp::resolver::results_type& endpoints);
         void send_request();
         void read_response();
+        void on_read(const asio::error_code& ec, std::size_t n);
+        void on_upstream_completed(bool reusable);
+        void deliver(size_t slot, size_t size);
+        void relay(size_t slot, size_t size);
+        void on_relayed(const asio::error_code& ec);
+        bool retry_on_fresh_connection();
+        void share_response(bool succeeded);
+        void fail();
         void generate_request();
 
     private:
         std::shared_ptr<HTTPSession> outer_session_;
         Context context_;
-        tcp::resolver resolver_;
-        asio::ssl::stream<tcp::socket> stream_;
-        std::array<char, buffer_size> buffer_;
-        std::stringstream response_;
+        ExchangePtr exchange_;
+        UpstreamPool::ConnectionPtr connection_;
+        HttpResponseFramer framer_;
+        bool retried_ = false;
+        size_t received_ = 0;
+        std::chrono::steady_clock::time_point started_at_;
+        // streaming relay double buffering: the next upstream read overlaps
+        // the client write of the previous chunk, at most one chunk waits for the client
+        std::array<std::array<char, buffer_size>, 2> buffers_;
+        size_t read_slot_ = 0;
+        asio::mutable_buffer read_buffer_;
+        bool reading_ = false;
+        bool relaying_ = false;
+        bool upstream_completed_ = false;
+        bool relay_failed_ = false;
+        bool persistent_ = true;
+        std::optional<std::pair<size_t, size_t>> pending_chunk_; // slot, size
+        std::shared_ptr<BufferChain> response_ = std::make_shared<BufferChain>();
         std::string http_request_;
+        HandlerMemory handler_memory_; // pending asynchronous operations of the upstream request
     };
 
 public:
-    HTTPSession(asio::io_context& io_, asio::ip::tcp::socket&& socket, uint64_t id);
+    // recycled blocks of the sessions, their exchanges and upstream requests (per worker thread)
+    struct SessionBlocks
+    {
+        static constexpr auto hits = &Stats::session_pool_hits;
+        static constexpr auto misses = &Stats::session_pool_misses;
+    };
+    struct ExchangeBlocks
+    {
+        static constexpr auto hits = &Stats::exchange_pool_hits;
+        static constexpr auto misses = &Stats::exchange_pool_misses;
+    };
+    struct OutgoingBlocks
+    {
+        static constexpr auto hits = &Stats::outgoing_pool_hits;
+        static constexpr auto misses = &Stats::outgoing_pool_misses;
+    };
+
+    // blocks kept by each thread for every object type, 0 disables the recycling
+    static void set_pool_capacity(size_t blocks);
+
+    // executor: serializes the session handlers (a strand unless the io_context is single-threaded)
+    HTTPSession(asio::io_context& io_, ClientStream&& stream, asio::any_io_executor executor, uint64_t id,
+                UpstreamPool& upstream_pool, RequestCoalescer& coalescer, ResponseCache& cache,
+                const SessionOptions& options);
     ~HTTPSession() override;
 
     void start() override;
+    // starts the session listed in a registry until destroyed
+    void start(SessionRegistry::Registration registration);
     void stop() override;
     uint64_t get_id() override
     {
@@ -81,25 +162,50 @@ public:
 protected:
     Context get_context()
     {
-        return {io_, strand_, tls_context_, request_, id_};
+        return {io_, executor_, upstream_pool_, coalescer_, cache_, options_, id_};
     }
     void on_request(HttpRequest request);
-    void on_outgoing_session_completed(const asio::error_code& ec, std::string response);
+    void on_outgoing_session_completed(const ExchangePtr& exchange, SharedBufferChain response,
+                                       bool persistent);
+    void on_outgoing_session_failed(const ExchangePtr& exchange, bool relay_started);
+    void write_response_part(asio::const_buffer buffer, std::shared_ptr<OutgoingSession> relay);
+    void on_response_relayed(bool persistent);
 
 private:
-    bool init_tls_context();
     void obtain_header();
+    bool can_read_ahead() const;
+    void read_header();
+    HttpRequestParser::Status parse_buffered();
+    void on_header();
+    void reject_request();
+    void arm_idle_timer();
+    bool serve_cached(const ExchangePtr& exchange);
+    void refresh(const ExchangePtr& exchange, const ResponseCache::Policy& policy);
+    bool join_flight(const ExchangePtr& exchange);
+    void complete_locally(const ExchangePtr& exchange, const HttpResponse& response);
+    void send_pending();
+    void on_response_sent(const asio::error_code& ec);
+    void close();
 
 private:
     asio::io_context& io_;
-    tcp::socket socket_;
-    HttpRequest request_;
-    asio::strand<asio::any_io_executor> strand_;
+    ClientStream stream_; // plain or TLS client connection
+    asio::any_io_executor executor_;
+    asio::steady_timer idle_timer_;
     asio::streambuf buffer_;
-    std::string raw_request_;
-    std::size_t content_length_ = 0;
-    asio::ssl::context tls_context_;
-    std::string response_;
+    HttpRequestParser parser_; // request head being received in buffer_
+    UpstreamPool& upstream_pool_;
+    RequestCoalescer& coalescer_;
+    ResponseCache& cache_;
+    const SessionOptions& options_;
+    SessionRegistry::Registration registration_;
+    HandlerMemory handler_memory_; // pending asynchronous operations of the session
+    std::deque<ExchangePtr> exchanges_;
     uint64_t id_{0};
+    uint64_t requests_ = 0;
+    bool awaiting_request_ = false;
+    bool reads_closed_ = false; // no further requests are accepted on the connection
+    bool writing_ = false;
+    bool closed_ = false;
     bool stopped_ = false;
 };
\ No newline at end of file
@@ -37,7 +37,8 @@ int main(int argc, char* argv[])
 
         gl_logger = init_logger(args.logger_type, args.log_level);
 
-        Server server(args.port, args.running_mode);
+        Server server(args.port, args.running_mode, args.server, args.upstream_pool, args.session,
+                      args.response_cache);
         server.run();
     }
     catch (const std::exception& e)
@@ -96,7 +97,7 @@ std::shared_ptr<spdlog::logger> init_logger(LoggerType logger_type,
 
 void show_usage(const cxxopts::Options& options)
 {
-    const char* samples_of_using_templ =
+    constexpr const char* samples_of_using_templ =
         R"(Command line samples:
     {app_name}
     {app_name} -h
@@ -1,13 +1,160 @@
 #include "server.h"
 #include "common/ec-handler.h"
+#include "common/stats.h"
+#include "coro-http-session.h"
 #include "http-session.h"
 #include "logs/logger.h"
+#include "utils/cpu-resources.h"
+#include "utils/header-scanner.h"
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <iterator>
+#include <system_error>
 
-Server::Server(unsigned short port, ServerRunningMode running_mode) : running_mode_(running_mode),
-                                                                      signals_(io_, SIGINT, SIGTERM),
-                                                                      acceptor_(io_, asio::ip::tcp::endpoint(tcp::v4(),
-                                                                                                             port)) {}
+namespace
+{
+#if defined(__linux__) && defined(SO_REUSEPORT)
+    // the kernel balances incoming connections across the listening sockets of a port
+    constexpr bool reuse_port_supported = true;
+    using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#else
+    constexpr bool reuse_port_supported = false;
+#endif
+
+    constexpr auto listen_monitor_interval = std::chrono::seconds(1);
+    constexpr auto accept_backoff = std::chrono::milliseconds(100);
+
+    // out of descriptors or kernel memory: accepting fails right away until some are released
+    bool is_resource_exhaustion(const asio::error_code& ec)
+    {
+        return (ec == asio::error::no_descriptors) || (ec == std::errc::too_many_files_open_in_system) ||
+               (ec == asio::error::no_buffer_space) || (ec == asio::error::no_memory);
+    }
+
+    // keeps the deepest accept queue seen
+    void sample_accept_queue(asio::ip::tcp::acceptor& acceptor)
+    {
+#ifdef __linux__
+        const auto length = accept_queue_length(acceptor.native_handle());
+        if (!length)
+            return;
+
+        uint64_t peak = gl_stats.accept_queue_peak.load(std::memory_order_relaxed);
+        while ((*length > peak) &&
+               !gl_stats.accept_queue_peak.compare_exchange_weak(peak, *length, std::memory_order_relaxed))
+        {
+        }
+#else
+        (void)acceptor;
+#endif
+    }
+
+    // new connection waiting for its first bytes, which tell TLS from plain HTTP,
+    // or for its TLS handshake to complete
+    struct PendingConnection
+    {
+        PendingConnection(ClientStream&& stream, const asio::any_io_executor& executor)
+            : stream(std::move(stream)), deadline(executor) {}
+
+        ClientStream stream;
+        asio::steady_timer deadline;
+        std::array<uint8_t, 3> head{};
+        bool timed_out = false;
+    };
+
+    void arm_deadline(const std::shared_ptr<PendingConnection>& pending, const asio::any_io_executor& executor,
+                      std::chrono::milliseconds timeout)
+    {
+        pending->deadline.expires_after(timeout);
+        pending->deadline.async_wait(asio::bind_executor(executor, [pending](const asio::error_code& ec)
+                                                         {
+                                                             if (ec)
+                                                                 return;
+
+                                                             // cancels the pending peek or handshake step
+                                                             pending->timed_out = true;
+                                                             asio::error_code ec_formal;
+                                                             pending->stream.socket().close(ec_formal);
+                                                         }));
+    }
+}
+
+Server::Worker::Worker(size_t index, int concurrency_hint, TlsClientContext& tls_client_context,
+                       const UpstreamPool::Options& upstream_pool_options)
+    : index(index), io(concurrency_hint), strand(asio::make_strand(io)), acceptor(io), tls_acceptor(io),
+      upstream_pool(io, tls_client_context, upstream_pool_options) {}
+
+Server::Server(unsigned short port, ServerRunningMode running_mode,
+               ServerOptions options, UpstreamPool::Options upstream_pool_options,
+               SessionOptions session_options,
+               ResponseCache::Options response_cache_options) : running_mode_(running_mode),
+                                                 options_(options),
+                                                 session_options_(session_options),
+                                                 threads_((options.threads > 0) ? options.threads : default_thread_count()),
+                                                 tls_client_context_(UpstreamPool::HOST),
+                                                 response_cache_(std::move(response_cache_options))
+{
+    // a single request is served by a single worker, accepted by a single accept,
+    // and answered with 'Connection: close' (the client doesn't wait for a further response)
+    if (running_mode_ == ServerRunningMode::SingleRequest)
+    {
+        options_.engine = EngineMode::Shared;
+        options_.pending_accepts = 1;
+        session_options_.keep_alive_timeout = std::chrono::seconds(0);
+    }
+    options_.pending_accepts = std::max<size_t>(options_.pending_accepts, 1);
+
+    HTTPSession::set_pool_capacity(options_.session_pool);
+
+    // certificate and key are loaded before anything is accepted, a failure prevents the startup
+    if (options_.tls.port != 0)
+        tls_server_context_.emplace(options_.tls.certificate_file, options_.tls.private_key_file);
+
+    if (options_.engine == EngineMode::PerCore)
+    {
+        for (size_t i = 0; i < threads_; i++)
+        {
+            workers_.push_back(std::make_unique<Worker>(i, 1, tls_client_context_, upstream_pool_options));
+
+            // without SO_REUSEPORT the first worker accepts for all of them
+            if (reuse_port_supported || (i == 0))
+                open_acceptors(*workers_.back(), port, reuse_port_supported);
+        }
+    }
+    else
+    {
+        workers_.push_back(std::make_unique<Worker>(0, static_cast<int>(threads_), tls_client_context_,
+                                                    upstream_pool_options));
+        open_acceptors(*workers_.back(), port, false);
+    }
+
+    signals_.emplace(workers_.front()->io, SIGINT, SIGTERM);
+    listen_monitor_.emplace(workers_.front()->strand);
+    listen_overflows_at_start_ = read_listen_overflows();
+}
+
+void Server::open_acceptors(Worker& worker, unsigned short port, bool reuse_port)
+{
+    open_acceptor(worker.acceptor, port, reuse_port);
+    if (tls_server_context_)
+        open_acceptor(worker.tls_acceptor, options_.tls.port, reuse_port);
+}
+
+void Server::open_acceptor(asio::ip::tcp::acceptor& acceptor, unsigned short port, bool reuse_port)
+{
+    const asio::ip::tcp::endpoint endpoint(tcp::v4(), port);
+
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+#if defined(__linux__) && defined(SO_REUSEPORT)
+    if (reuse_port)
+        acceptor.set_option(::reuse_port(true));
+#endif
+    acceptor.bind(endpoint);
+    acceptor.listen((options_.listen_backlog > 0) ? options_.listen_backlog
+                                                  : static_cast<int>(asio::socket_base::max_listen_connections));
+}
 
 int Server::run()
 {
@@ -15,17 +162,54 @@ int Server::run()
 
     install_signals_handler();
 
-    listener();
+    for (auto& worker : workers_)
+    {
+        // the pool maintenance would keep a single-request server running
+        if (running_mode_ == ServerRunningMode::Persistent)
+            worker->upstream_pool.start();
+
+        // several accepts outstanding: a burst of connections is taken off the accept queue
+        // by one reactor wake-up instead of one connection per completion
+        for (size_t i = 0; i < options_.pending_accepts; i++)
+        {
+            if (worker->acceptor.is_open())
+                listener(*worker, worker->acceptor, false);
+            if (worker->tls_acceptor.is_open())
+                listener(*worker, worker->tls_acceptor, true);
+        }
+    }
+
+    if ((running_mode_ == ServerRunningMode::Persistent) && listen_overflows_at_start_)
+        asio::post(workers_.front()->strand, [this]()
+                   { monitor_listen_overflows(); });
+
+    const bool per_core = (options_.engine == EngineMode::PerCore);
+    const std::vector<unsigned> cpus = allowed_cpus();
+
+    gl_logger->info("Server, engine: {}, worker threads: {}{}, sessions: {}, I/O: {}, header scan: {}, pending accepts: {}",
+                    per_core ? "per-core" : "shared", threads_, options_.pin_threads ? " (pinned)" : "",
+                    (options_.session_engine == SessionEngine::Coroutine) ? "coroutine" : "callback", io_backend,
+                    scan_isa_name(native_scan_isa), options_.pending_accepts);
+    if (tls_server_context_)
+        gl_logger->info("Server, TLS port: {}", options_.tls.port);
 
     std::vector<std::thread> threads;
 
-    for (size_t i = 0; i < 3; i++)
-        threads.emplace_back([this]()
-                             { io_.run(); });
+    for (size_t i = 0; i < threads_; i++)
+        threads.emplace_back([this, i, per_core, &cpus]()
+                             {
+                                 if (options_.pin_threads)
+                                 {
+                                     const unsigned cpu = cpus[i % cpus.size()];
+                                     if (!pin_current_thread(cpu))
+                                         gl_logger->warn("Server, worker thread {} not pinned to CPU {}", i, cpu);
+                                 }
+                                 workers_[per_core ? i : 0]->io.run();
+                             });
     for (auto& th : threads)
         th.join();
 
-    gl_logger->info("Server finished");
+    gl_logger->info("Server finished, stats: {}", gl_stats.to_json());
 
     return 0;
 }
@@ -36,70 +220,240 @@ void Server::schedule_shutdown()
 
     shutdown_pending_ = true;
 
-    for (auto it = sessions_.begin(); it != sessions_.end(); )
+    gl_logger->info("Server, stopping {} sessions", sessions_.size());
+    sessions_.for_each([](Session& session)
+                       { session.stop(); });
+
+    for (auto& worker_ptr : workers_)
     {
-        if (auto session = it->lock())
-        {
-            session->stop();
-            ++it;
-        }
-        else
-        {
-            it = sessions_.erase(it);
-        }
+        Worker& worker = *worker_ptr;
+        asio::post(worker.strand, [&worker]()
+                   {
+                       asio::error_code ec_formal;
+                       worker.acceptor.close(ec_formal);
+                       worker.tls_acceptor.close(ec_formal);
+                       worker.upstream_pool.stop();
+                   });
     }
-    
-    acceptor_.close();
+    asio::post(workers_.front()->strand, [this]()
+               { listen_monitor_->cancel(); });
 }
 
-void Server::listener()
+// the kernel's accept queue overflow counters (network namespace wide), relative to the server startup
+void Server::monitor_listen_overflows()
 {
-    acceptor_.async_accept(
-        [this](const asio::error_code& ec, asio::ip::tcp::socket socket)
+    listen_monitor_->expires_after(listen_monitor_interval);
+    listen_monitor_->async_wait(
+        [this](const asio::error_code& ec)
         {
-            if (check_ec(ec, __func__))
+            if (ec || shutdown_pending_)
+                return;
+
+            const auto current = read_listen_overflows();
+            if (current && (current->overflows >= listen_overflows_at_start_->overflows) &&
+                (current->drops >= listen_overflows_at_start_->drops))
             {
-                gl_logger->info("Server accepted connection");
+                const uint64_t overflows = current->overflows - listen_overflows_at_start_->overflows;
+                const uint64_t previous =
+                    gl_stats.namespace_listen_overflows.exchange(overflows, std::memory_order_relaxed);
+                gl_stats.namespace_listen_drops.store(current->drops - listen_overflows_at_start_->drops,
+                                                      std::memory_order_relaxed);
 
-                dispatch_request(std::move(socket));
+                // any listener of the network namespace, another service on the host included
+                if (overflows > previous)
+                    gl_logger->warn("Server, {} connections refused by a full accept queue in the network namespace "
+                                    "(not necessarily this server's, listen backlog: {})",
+                                    overflows - previous,
+                                    (options_.listen_backlog > 0) ? std::to_string(options_.listen_backlog)
+                                                                  : std::string("system maximum"));
             }
-
-            if ((running_mode_ == ServerRunningMode::Persistent) && !shutdown_pending_)
-                listener();
+            monitor_listen_overflows();
         });
 }
 
-void Server::dispatch_request(asio::ip::tcp::socket socket)
+// worker owning the next connection accepted by the first one (no SO_REUSEPORT)
+Server::Worker& Server::next_worker()
+{
+    return *workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+}
+
+void Server::listener(Worker& worker, asio::ip::tcp::acceptor& acceptor, bool tls)
+{
+    const bool hand_off = (options_.engine == EngineMode::PerCore) && !reuse_port_supported;
+    Worker& owner = hand_off ? next_worker() : worker;
+
+    // the accepted socket belongs to the owner's io_context
+    acceptor.async_accept(
+        owner.io,
+        asio::bind_executor(worker.strand,
+                            [this, &worker, &owner, &acceptor, tls](const asio::error_code& ec, asio::ip::tcp::socket socket)
+                            {
+                                if (check_ec(ec, __func__))
+                                {
+                                    gl_logger->info("Server accepted {}connection", tls ? "TLS " : "");
+                                    gl_stats.accepted.fetch_add(1, std::memory_order_relaxed);
+                                    sample_accept_queue(acceptor);
+
+                                    auto dispatch = [this, &owner, tls](asio::ip::tcp::socket socket)
+                                    {
+                                        if (tls)
+                                            dispatch_tls_request(owner, std::move(socket));
+                                        else
+                                            dispatch_request(owner, std::move(socket));
+                                    };
+
+                                    if (&owner == &worker)
+                                        dispatch(std::move(socket));
+                                    else
+                                        asio::post(owner.strand, [dispatch, socket = std::move(socket)]() mutable
+                                                   { dispatch(std::move(socket)); });
+                                }
+                                else if (ec != asio::error::operation_aborted)
+                                {
+                                    gl_stats.accept_errors.fetch_add(1, std::memory_order_relaxed);
+
+                                    // accepting again at once would fail the same way, every pending accept
+                                    // spinning on it: re-armed once some descriptors may have been released
+                                    if (is_resource_exhaustion(ec))
+                                    {
+                                        auto backoff = std::make_shared<asio::steady_timer>(worker.strand, accept_backoff);
+                                        backoff->async_wait([this, &worker, &acceptor, tls, backoff](const asio::error_code&)
+                                                            {
+                                                                if ((running_mode_ == ServerRunningMode::Persistent) &&
+                                                                    !shutdown_pending_)
+                                                                    listener(worker, acceptor, tls);
+                                                            });
+                                        return;
+                                    }
+                                }
+
+                                if ((running_mode_ == ServerRunningMode::Persistent) && !shutdown_pending_)
+                                    listener(worker, acceptor, tls);
+                            }));
+}
+
+// a single-threaded io_context serializes the session handlers by itself
+asio::any_io_executor Server::session_executor(Worker& worker)
+{
+    return (options_.engine == EngineMode::PerCore) ? asio::any_io_executor(worker.io.get_executor())
+                                                    : asio::any_io_executor(asio::make_strand(worker.io));
+}
+
+void Server::dispatch_request(Worker& worker, asio::ip::tcp::socket socket)
+{
+    asio::any_io_executor executor = session_executor(worker);
+
+    // the first bytes are peeked asynchronously: a client connecting without sending anything
+    // holds neither an io thread nor the accept loop, and is dropped once the deadline passes
+    auto pending = std::make_shared<PendingConnection>(ClientStream(std::move(socket)), executor);
+    arm_deadline(pending, executor, options_.first_byte_timeout);
+
+    pending->stream.socket().async_receive(
+        asio::buffer(pending->head), asio::socket_base::message_peek,
+        asio::bind_executor(executor, [this, &worker, pending, executor](const asio::error_code& ec, size_t n)
+                            {
+                                pending->deadline.cancel();
+
+                                if (pending->timed_out)
+                                {
+                                    gl_stats.client_first_byte_timeouts.fetch_add(1, std::memory_order_relaxed);
+                                    gl_logger->warn("Server, connection closed, no request within {} ms",
+                                                    options_.first_byte_timeout.count());
+                                }
+                                else if (is_eof(ec))
+                                {
+                                    asio::error_code ec_formal;
+                                    pending->stream.socket().close(ec_formal);
+                                }
+                                else if (check_ec(ec, __func__))
+                                    on_first_bytes(worker, std::move(pending->stream), executor, pending->head.data(), n);
+                            }));
+}
+
+void Server::dispatch_tls_request(Worker& worker, asio::ip::tcp::socket socket)
+{
+    asio::any_io_executor executor = session_executor(worker);
+
+    // the handshake has to be done within the first bytes deadline
+    auto pending = std::make_shared<PendingConnection>(
+        ClientStream(std::move(socket), tls_server_context_->native_handle()), executor);
+    arm_deadline(pending, executor, options_.first_byte_timeout);
+
+    pending->stream.async_handshake(
+        asio::bind_executor(executor, [this, &worker, pending, executor](const asio::error_code& ec)
+                            {
+                                pending->deadline.cancel();
+
+                                if (pending->timed_out)
+                                {
+                                    gl_stats.client_first_byte_timeouts.fetch_add(1, std::memory_order_relaxed);
+                                    gl_logger->warn("Server, TLS connection closed, no handshake within {} ms",
+                                                    options_.first_byte_timeout.count());
+                                }
+                                else if (check_ec(ec, __func__))
+                                {
+                                    gl_logger->debug("Server, TLS handshake done{}{}",
+                                                     pending->stream.tls_resumed() ? ", resumed" : "",
+                                                     pending->stream.ktls_send() ? ", kTLS" : "");
+                                    start_session(worker, std::move(pending->stream), executor);
+                                }
+                                else
+                                {
+                                    asio::error_code ec_formal;
+                                    pending->stream.socket().close(ec_formal);
+                                }
+                            }));
+}
+
+void Server::on_first_bytes(Worker& worker, ClientStream stream, asio::any_io_executor executor,
+                            const uint8_t* data, size_t size)
 {
     constexpr uint8_t tls_handshake_sign[] = {0x16, 0x03, 0x01};
 
-    std::array<uint8_t, 3> buff;
-    size_t n = socket.receive(asio::buffer(buff),
-                              asio::socket_base::message_peek);
     // check if https protocol:
-    if ((n >= buff.size()) &&
-        (buff[0] == tls_handshake_sign[0] && buff[1] == tls_handshake_sign[1]))
+    if ((size >= std::size(tls_handshake_sign)) &&
+        (data[0] == tls_handshake_sign[0] && data[1] == tls_handshake_sign[1]))
     {
         // preventing from access via https link
         // e.g.  https://localhost:8080/api/v3/time
-        gl_logger->error("Refused! (HTTPS protocol is currently not supported)");
+        if (tls_server_context_)
+            gl_logger->error("Refused! (HTTPS is served on port {})", options_.tls.port);
+        else
+            gl_logger->error("Refused! (HTTPS protocol is not enabled)");
 
         asio::error_code ec_formal;
-        auto rc = socket.shutdown(tcp::socket::shutdown_both, ec_formal);
-        socket.close();
+        stream.socket().shutdown(tcp::socket::shutdown_both, ec_formal);
+        stream.socket().close(ec_formal);
     }
     else
     {
-        auto session = std::make_shared<HTTPSession>(io_, std::move(socket),
-                                                     generate_session_id());
-        sessions_.push_back(session);
-        session->start();
+        start_session(worker, std::move(stream), executor);
     }
 }
 
+void Server::start_session(Worker& worker, ClientStream stream, asio::any_io_executor executor)
+{
+#ifdef MB_COROUTINES
+    if (options_.session_engine == SessionEngine::Coroutine)
+    {
+        auto session = std::make_shared<CoroutineHTTPSession>(worker.io, std::move(stream), executor,
+                                                               generate_session_id(), worker.upstream_pool,
+                                                               request_coalescer_, response_cache_, session_options_);
+        session->start(sessions_.add(session));
+        return;
+    }
+#endif
+
+    auto session = std::allocate_shared<HTTPSession>(RecyclingAllocator<HTTPSession, HTTPSession::SessionBlocks>(),
+                                                     worker.io, std::move(stream), executor, generate_session_id(),
+                                                     worker.upstream_pool, request_coalescer_, response_cache_,
+                                                     session_options_);
+    session->start(sessions_.add(session));
+}
+
 void Server::install_signals_handler()
 {
-    signals_.async_wait(
+    signals_->async_wait(
         [this](const asio::error_code& ec, int signo)
         {
             if (check_ec(ec, __func__))
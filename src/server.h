@@ -4,8 +4,34 @@
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "common/session.h"
+#include "client-stream.h"
+#include "tls-client-context.h"
+#include "tls-server-context.h"
+#include "upstream-pool.h"
+#include "utils/listen-queue.h"
+#include "utils/request-coalescer.h"
+#include "utils/response-cache.h"
+#include "utils/session-registry.h"
+
+// reactor running the socket I/O, io_uring in MB_IO_URING builds
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+constexpr const char* io_backend = "io_uring";
+#elif defined(ASIO_HAS_IOCP)
+constexpr const char* io_backend = "iocp";
+#elif defined(ASIO_HAS_EPOLL)
+constexpr const char* io_backend = "epoll";
+#elif defined(ASIO_HAS_KQUEUE)
+constexpr const char* io_backend = "kqueue";
+#else
+constexpr const char* io_backend = "select";
+#endif
 
 enum class ServerRunningMode
 {
@@ -13,6 +39,39 @@ enum class ServerRunningMode
     SingleRequest // Handle exactly one request, then stop
 };
 
+enum class EngineMode
+{
+    Shared, // Default: worker threads share one io_context and acceptor, sessions are serialized by strands
+    PerCore // one io_context, acceptor (SO_REUSEPORT) and upstream pool per worker thread
+};
+
+enum class SessionEngine
+{
+    Callback, // Default: chained completion handlers (HTTPSession)
+    Coroutine // C++20 coroutines (CoroutineHTTPSession), MB_COROUTINES builds only
+};
+
+struct InboundTlsOptions
+{
+    unsigned short port = 0; // 0: TLS clients are refused
+    std::string certificate_file; // PEM certificate chain
+    std::string private_key_file; // PEM
+};
+
+struct ServerOptions
+{
+    size_t threads = 0;       // worker threads, 0: one per CPU available to the process (cgroup quota)
+    bool pin_threads = false; // each worker thread bound to its own CPU
+    EngineMode engine = EngineMode::Shared;
+    SessionEngine session_engine = SessionEngine::Callback;
+    size_t session_pool = 256; // session objects of each kind kept for reuse per worker thread, 0: none
+    size_t pending_accepts = 4; // accepts kept outstanding on each listening socket
+    int listen_backlog = 0;     // accept queue length, 0: the system maximum (SOMAXCONN)
+    std::chrono::milliseconds first_byte_timeout{2000}; // a new connection sending nothing meanwhile is closed
+                                                        // (TLS: not done with the handshake)
+    InboundTlsOptions tls;
+};
+
 class HTTPSession;
 
 class Server
@@ -24,20 +83,55 @@ class Server
         return session_id_gen.fetch_add(1, std::memory_order_relaxed);
     }
 
+    // io_context with its acceptor and upstream pool, run by all the worker threads (shared engine)
+    // or by a single one (per-core engine: a connection never leaves its thread)
+    struct Worker
+    {
+        Worker(size_t index, int concurrency_hint, TlsClientContext& tls_client_context,
+               const UpstreamPool::Options& upstream_pool_options);
+
+        size_t index;
+        asio::io_context io;
+        asio::strand<asio::io_context::executor_type> strand; // acceptors
+        asio::ip::tcp::acceptor acceptor;
+        asio::ip::tcp::acceptor tls_acceptor;
+        UpstreamPool upstream_pool;
+    };
+
 public:
-    Server(unsigned short port, ServerRunningMode running_mode = ServerRunningMode::Persistent);
+    Server(unsigned short port, ServerRunningMode running_mode = ServerRunningMode::Persistent,
+           ServerOptions options = {}, UpstreamPool::Options upstream_pool_options = {}, SessionOptions session_options = {},
+           ResponseCache::Options response_cache_options = {});
     int run();
     void schedule_shutdown();
 
 private:
-    void listener();
-    void dispatch_request(asio::ip::tcp::socket socket);
+    void open_acceptors(Worker& worker, unsigned short port, bool reuse_port);
+    void open_acceptor(asio::ip::tcp::acceptor& acceptor, unsigned short port, bool reuse_port);
+    void listener(Worker& worker, asio::ip::tcp::acceptor& acceptor, bool tls);
+    void monitor_listen_overflows();
+    Worker& next_worker();
+    void dispatch_request(Worker& worker, asio::ip::tcp::socket socket);
+    void dispatch_tls_request(Worker& worker, asio::ip::tcp::socket socket);
+    void on_first_bytes(Worker& worker, ClientStream stream, asio::any_io_executor executor,
+                        const uint8_t* data, size_t size);
+    void start_session(Worker& worker, ClientStream stream, asio::any_io_executor executor);
+    asio::any_io_executor session_executor(Worker& worker);
     void install_signals_handler();
 
     ServerRunningMode running_mode_;
-    asio::io_context io_;
-    asio::ip::tcp::acceptor acceptor_;
-    asio::signal_set signals_;
-    bool shutdown_pending_ = false;
-    std::vector<std::weak_ptr<Session>> sessions_;
+    ServerOptions options_;
+    SessionOptions session_options_;
+    size_t threads_;
+    TlsClientContext tls_client_context_;
+    std::optional<TlsServerContext> tls_server_context_;
+    RequestCoalescer request_coalescer_;
+    ResponseCache response_cache_;
+    SessionRegistry sessions_; // outlives the workers: sessions left in their io_contexts unregister on destruction
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::optional<asio::signal_set> signals_;
+    std::optional<asio::steady_timer> listen_monitor_;       // samples the kernel's accept queue overflow counters
+    std::optional<ListenOverflows> listen_overflows_at_start_;
+    std::atomic<bool> shutdown_pending_{false};
+    std::atomic<size_t> next_worker_{0}; // round robin hand-off without SO_REUSEPORT
 };
@@ -0,0 +1,62 @@
+#include "tls-client-context.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <stdexcept>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+
+TlsClientContext::TlsClientContext(const std::string& host)
+    : context_(asio::ssl::context::tls_client)
+{
+    const auto started_at = std::chrono::steady_clock::now();
+
+    context_.set_options(asio::ssl::context::default_workarounds |
+                         asio::ssl::context::no_sslv2 |
+                         asio::ssl::context::no_sslv3 |
+                         asio::ssl::context::no_compression);
+
+    SSL_CTX* native_context = context_.native_handle();
+    if ((SSL_CTX_set_min_proto_version(native_context, TLS1_2_VERSION) != 1) ||
+        (SSL_CTX_set_cipher_list(native_context, cipher_list.c_str()) != 1))
+    {
+        throw std::runtime_error("TLS initialization failure (cipher list)");
+    }
+
+    load_verify_paths();
+
+    // Verify server certificate (important)
+    context_.set_verify_mode(asio::ssl::verify_peer);
+    context_.set_verify_callback(asio::ssl::host_name_verification(host));
+
+    session_cache_.attach(native_context);
+
+    build_time_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started_at);
+    gl_stats.tls_context_build_us.store(build_time_.count(), std::memory_order_relaxed);
+
+    gl_logger->info("TLS client context built in {} us", build_time_.count());
+}
+
+void TlsClientContext::load_verify_paths()
+{
+    std::string failure_hints;
+
+    try
+    {
+#ifdef _WIN32
+        const std::string cert_path = "certs\\cacert.pem";
+        failure_hints = fmt::format("(possibly SSL certificate not found ({})", cert_path);
+
+        context_.load_verify_file(cert_path);
+#else
+        // Use system CA certificates (Linux/macOS typically OK),
+        // certificates looked up in the CA directory stay cached in the shared store
+        context_.set_default_verify_paths();
+#endif
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error(fmt::format("TLS initialization failure {} {}", e.what(), failure_hints));
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <chrono>
+#include <string>
+
+#include "tls-session-cache.h"
+
+// Process-wide TLS client context for upstream connections.
+// Built once at server startup (CA store, cipher list, peer verification)
+// and shared read-only by all outgoing connections.
+class TlsClientContext
+{
+    inline static const std::string cipher_list = "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                                  "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384:"
+                                                  "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-RSA-CHACHA20-POLY1305";
+
+public:
+    explicit TlsClientContext(const std::string& host);
+
+    TlsClientContext(const TlsClientContext&) = delete;
+    TlsClientContext& operator=(const TlsClientContext&) = delete;
+
+    asio::ssl::context& get() { return context_; }
+    TlsSessionCache& session_cache() { return session_cache_; }
+    std::chrono::microseconds build_time() const { return build_time_; }
+
+private:
+    void load_verify_paths();
+
+private:
+    asio::ssl::context context_;
+    TlsSessionCache session_cache_;
+    std::chrono::microseconds build_time_{0};
+};
@@ -0,0 +1,55 @@
+#include "tls-server-context.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <stdexcept>
+
+#include "logs/logger.h"
+
+TlsServerContext::TlsServerContext(const std::string& certificate_file, const std::string& private_key_file)
+    : context_(asio::ssl::context::tls_server)
+{
+    context_.set_options(asio::ssl::context::default_workarounds |
+                         asio::ssl::context::no_sslv2 |
+                         asio::ssl::context::no_sslv3 |
+                         asio::ssl::context::no_compression);
+
+    SSL_CTX* native_context = context_.native_handle();
+    if ((SSL_CTX_set_min_proto_version(native_context, TLS1_2_VERSION) != 1) ||
+        (SSL_CTX_set_cipher_list(native_context, cipher_list.c_str()) != 1))
+    {
+        throw std::runtime_error("TLS server initialization failure (cipher list)");
+    }
+
+    try
+    {
+        context_.use_certificate_chain_file(certificate_file);
+        context_.use_private_key_file(private_key_file, asio::ssl::context::pem);
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error(fmt::format("TLS server initialization failure {} (certificate: {}, key: {})",
+                                             e.what(), certificate_file, private_key_file));
+    }
+
+    // resumption: stateless tickets (the ticket keys are generated per context)
+    // and a server-side cache for the clients not supporting them
+    static const unsigned char session_id_context[] = APP_NAME;
+    SSL_CTX_set_session_id_context(native_context, session_id_context, sizeof(session_id_context) - 1);
+    SSL_CTX_set_session_cache_mode(native_context, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(native_context, session_cache_size);
+    SSL_CTX_set_num_tickets(native_context, tickets_per_handshake);
+
+    // records written partially on a would-block are completed with the remaining buffer;
+    // a client closing the connection without close_notify is a plain end of stream
+    SSL_CTX_set_mode(native_context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    SSL_CTX_set_options(native_context, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_CTX_set_options(native_context, SSL_OP_ENABLE_KTLS);
+    gl_logger->info("TLS server context built, certificate: {}, kTLS requested", certificate_file);
+#else
+    gl_logger->info("TLS server context built, certificate: {}, kTLS not available", certificate_file);
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <string>
+
+// Process-wide TLS server context for inbound client connections.
+// The certificate chain and the private key are loaded once at server startup,
+// the context (ticket keys and session cache included) is shared by all the
+// workers, so a client resumes its session whichever worker accepts it.
+class TlsServerContext
+{
+    inline static const std::string cipher_list = "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                                  "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384:"
+                                                  "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-RSA-CHACHA20-POLY1305";
+
+    // full handshake sessions remembered for TLS 1.2 clients without ticket support
+    constexpr static long session_cache_size = 20 * 1024;
+    // session tickets sent after a TLS 1.3 handshake
+    constexpr static size_t tickets_per_handshake = 2;
+
+public:
+    TlsServerContext(const std::string& certificate_file, const std::string& private_key_file);
+
+    TlsServerContext(const TlsServerContext&) = delete;
+    TlsServerContext& operator=(const TlsServerContext&) = delete;
+
+    asio::ssl::context& get() { return context_; }
+    SSL_CTX* native_handle() { return context_.native_handle(); }
+
+private:
+    asio::ssl::context context_;
+};
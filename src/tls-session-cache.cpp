@@ -0,0 +1,98 @@
+#include "tls-session-cache.h"
+
+#include "common/stats.h"
+#include "logs/logger.h"
+
+namespace
+{
+    int cache_ex_index()
+    {
+        static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+}
+
+TlsSessionCache::~TlsSessionCache()
+{
+    for (auto& [host, session] : sessions_)
+        SSL_SESSION_free(session);
+}
+
+void TlsSessionCache::attach(SSL_CTX* context)
+{
+    SSL_CTX_set_ex_data(context, cache_ex_index(), this);
+
+    // TLS 1.3 tickets arrive after the handshake, so sessions are collected by the callback
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context, &TlsSessionCache::on_new_session);
+}
+
+bool TlsSessionCache::apply(SSL* ssl, const std::string& host)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = sessions_.find(host);
+    if (it == sessions_.end())
+        return false;
+
+    // each connection works on its own copy, an unclean close of the connection
+    // marks its session as not resumable
+    SSL_SESSION* session = SSL_SESSION_dup(it->second);
+    if (nullptr == session)
+        return false;
+
+    bool result = (SSL_set_session(ssl, session) == 1);
+    SSL_SESSION_free(session);
+    return result;
+}
+
+void TlsSessionCache::store(const std::string& host, SSL_SESSION* session)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto [it, inserted] = sessions_.emplace(host, session);
+    if (!inserted)
+    {
+        SSL_SESSION_free(it->second);
+        it->second = session;
+    }
+}
+
+void TlsSessionCache::remove(const std::string& host)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = sessions_.find(host);
+    if (it != sessions_.end())
+    {
+        SSL_SESSION_free(it->second);
+        sessions_.erase(it);
+    }
+}
+
+void TlsSessionCache::on_handshake(SSL* ssl)
+{
+    if (SSL_session_reused(ssl))
+        gl_stats.tls_handshakes_resumed.fetch_add(1, std::memory_order_relaxed);
+    else
+        gl_stats.tls_handshakes_full.fetch_add(1, std::memory_order_relaxed);
+}
+
+int TlsSessionCache::on_new_session(SSL* ssl, SSL_SESSION* session)
+{
+    auto* cache = static_cast<TlsSessionCache*>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), cache_ex_index()));
+    const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+
+    if ((nullptr == cache) || (nullptr == host) || !SSL_SESSION_is_resumable(session))
+        return 0;
+
+    SSL_SESSION* copy = SSL_SESSION_dup(session);
+    if (nullptr == copy)
+        return 0;
+
+    gl_logger->debug("TLS session cached for {}", host);
+
+    cache->store(host, copy);
+    return 0; // the connection keeps its own reference
+}
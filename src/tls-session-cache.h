@@ -0,0 +1,38 @@
+#pragma once
+
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string>
+#include <unordered_map>
+
+// TLS session (ticket) cache for upstream handshakes, keyed by host name.
+// Keeps the most recent resumable session per host, new connections
+// offer it to the server and fall back to a full handshake if it is declined.
+class TlsSessionCache
+{
+public:
+    TlsSessionCache() = default;
+    ~TlsSessionCache();
+
+    TlsSessionCache(const TlsSessionCache&) = delete;
+    TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+    // installs the new session callback on the client context
+    void attach(SSL_CTX* context);
+
+    // offers a cached session (if any) for the next handshake
+    bool apply(SSL* ssl, const std::string& host);
+    // takes ownership of the session reference
+    void store(const std::string& host, SSL_SESSION* session);
+    void remove(const std::string& host);
+
+    // to be called once the handshake has completed
+    static void on_handshake(SSL* ssl);
+
+private:
+    static int on_new_session(SSL* ssl, SSL_SESSION* session);
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, SSL_SESSION*> sessions_;
+};
@@ -0,0 +1,260 @@
+#include "upstream-pool.h"
+
+#include "common/ec-handler.h"
+#include "common/stats.h"
+#include "logs/logger.h"
+
+namespace
+{
+    constexpr auto maintenance_interval = std::chrono::seconds(1);
+}
+
+UpstreamPool::UpstreamPool(asio::io_context& io, TlsClientContext& tls_context, Options options)
+    : io_(io), options_(options), tls_context_(tls_context),
+      resolver_(io, HOST, PORT, options.dns_ttl),
+      strand_(asio::make_strand(io.get_executor())), maintenance_timer_(strand_) {}
+
+void UpstreamPool::start()
+{
+    gl_logger->info("UpstreamPool started, min: {}, max: {}, idle timeout: {}s",
+                    options_.min_size, options_.max_size, options_.idle_timeout.count());
+
+    resolver_.start();
+
+    asio::post(strand_, [this]()
+               {
+                   warm_up();
+                   schedule_maintenance();
+               });
+}
+
+void UpstreamPool::stop()
+{
+    std::deque<ConnectionPtr> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        idle.swap(idle_);
+    }
+
+    for (auto& connection : idle)
+        close(*connection);
+
+    resolver_.stop();
+
+    asio::post(strand_, [this]()
+               { maintenance_timer_.cancel(); });
+
+    gl_logger->info("UpstreamPool stopped, connections created: {}, reused: {}, evicted: {}",
+                    gl_stats.upstream_connections_created.load(),
+                    gl_stats.upstream_connections_reused.load(),
+                    gl_stats.upstream_connections_evicted.load());
+}
+
+void UpstreamPool::release(ConnectionPtr connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopped_ && (idle_.size() < options_.max_size) &&
+            connection->stream.lowest_layer().is_open())
+        {
+            gl_logger->debug("UpstreamConnection released, id: {}, reused: {}",
+                             connection->id, connection->reuse_count);
+
+            connection->idle_since = std::chrono::steady_clock::now();
+            idle_.push_back(std::move(connection));
+            return;
+        }
+    }
+
+    close(*connection);
+}
+
+void UpstreamPool::acquire_impl(ConnectHandler handler, bool reuse)
+{
+    if (reuse)
+    {
+        if (auto connection = take_idle())
+        {
+            connection->reuse_count++;
+            gl_stats.upstream_connections_reused.fetch_add(1, std::memory_order_relaxed);
+            gl_logger->debug("UpstreamConnection reused, id: {}, reused: {}",
+                             connection->id, connection->reuse_count);
+
+            handler({}, std::move(connection));
+            return;
+        }
+    }
+
+    establish(std::move(handler));
+}
+
+UpstreamPool::ConnectionPtr UpstreamPool::take_idle()
+{
+    const auto expired_since = std::chrono::steady_clock::now() - options_.idle_timeout;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!idle_.empty())
+    {
+        ConnectionPtr connection = std::move(idle_.back());
+        idle_.pop_back();
+
+        if (connection->idle_since > expired_since)
+            return connection;
+
+        close(*connection);
+        gl_stats.upstream_connections_evicted.fetch_add(1, std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+void UpstreamPool::establish(ConnectHandler handler)
+{
+    auto connection = std::make_shared<UpstreamConnection>(
+        io_, tls_context_.get(), connection_id_gen_.fetch_add(1, std::memory_order_relaxed));
+
+    if (!init_ssl(*connection))
+    {
+        handler(asio::error::invalid_argument, nullptr);
+        return;
+    }
+
+    resolver_.resolve(
+        [this, connection, handler](const asio::error_code& ec, UpstreamResolver::Endpoints endpoints)
+        {
+            if (!check_ec(ec, "UpstreamPool::resolve"))
+            {
+                handler(ec, nullptr);
+                return;
+            }
+
+            auto racer = std::make_shared<ConnectRacer>(
+                io_, *endpoints, endpoint_scores_, options_.connect_stagger,
+                [this, connection, handler](const asio::error_code& ec, tcp::socket socket)
+                {
+                    if (!check_ec(ec, "UpstreamPool::connect"))
+                    {
+                        handler(ec, nullptr);
+                        return;
+                    }
+
+                    connection->stream.next_layer() = std::move(socket);
+
+                    connection->stream.async_handshake(
+                        asio::ssl::stream_base::client,
+                        [this, connection, handler](const asio::error_code& ec)
+                        {
+                            if (!check_ec(ec, "UpstreamPool::handshake"))
+                            {
+                                // the offered session might have caused the failure
+                                tls_context_.session_cache().remove(HOST);
+                                handler(ec, nullptr);
+                                return;
+                            }
+
+                            TlsSessionCache::on_handshake(connection->stream.native_handle());
+                            gl_stats.upstream_connections_created.fetch_add(1, std::memory_order_relaxed);
+                            gl_logger->debug("UpstreamConnection established, id: {}", connection->id);
+
+                            handler(ec, connection);
+                        });
+                });
+            racer->start();
+        });
+}
+
+bool UpstreamPool::init_ssl(UpstreamConnection& connection)
+{
+    // peer verification is configured once in the shared TLS client context
+
+    // SNI (many hosts require it)
+    bool result = SSL_set_tlsext_host_name(connection.stream.native_handle(), HOST.c_str());
+    if (!result)
+    {
+        gl_logger->error("Failed to set SNI host name {}", HOST);
+    }
+    else
+    {
+        tls_context_.session_cache().apply(connection.stream.native_handle(), HOST);
+    }
+    return result;
+}
+
+void UpstreamPool::warm_up()
+{
+    size_t missing(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || (std::chrono::steady_clock::now() < warm_up_retry_after_))
+            return;
+
+        const size_t available = idle_.size() + warming_;
+        if (available < options_.min_size)
+            missing = options_.min_size - available;
+        warming_ += missing;
+    }
+
+    for (size_t i = 0; i < missing; i++)
+    {
+        establish([this](const asio::error_code& ec, ConnectionPtr connection)
+                  {
+                      {
+                          std::lock_guard<std::mutex> lock(mutex_);
+                          warming_--;
+                          // back off after a failure instead of retrying each maintenance cycle
+                          if (ec)
+                              warm_up_retry_after_ = std::chrono::steady_clock::now() + options_.idle_timeout;
+                      }
+                      if (!ec)
+                          release(std::move(connection));
+                  });
+    }
+}
+
+void UpstreamPool::schedule_maintenance()
+{
+    maintenance_timer_.expires_after(maintenance_interval);
+    maintenance_timer_.async_wait(
+        [this](const asio::error_code& ec)
+        {
+            if (ec == asio::error::operation_aborted)
+                return;
+
+            evict_expired();
+            warm_up();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!stopped_)
+                schedule_maintenance();
+        });
+}
+
+void UpstreamPool::evict_expired()
+{
+    const auto expired_since = std::chrono::steady_clock::now() - options_.idle_timeout;
+
+    std::deque<ConnectionPtr> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!idle_.empty() && (idle_.front()->idle_since <= expired_since))
+        {
+            expired.push_back(std::move(idle_.front()));
+            idle_.pop_front();
+        }
+    }
+
+    for (auto& connection : expired)
+    {
+        gl_logger->debug("UpstreamConnection evicted, id: {}, reused: {}",
+                         connection->id, connection->reuse_count);
+        close(*connection);
+    }
+    gl_stats.upstream_connections_evicted.fetch_add(expired.size(), std::memory_order_relaxed);
+}
+
+void UpstreamPool::close(UpstreamConnection& connection)
+{
+    asio::error_code ec_formal;
+    connection.stream.lowest_layer().shutdown(tcp::socket::shutdown_both, ec_formal);
+    connection.stream.lowest_layer().close(ec_formal);
+}
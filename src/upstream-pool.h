@@ -0,0 +1,114 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ssl.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "connect-racer.h"
+#include "tls-client-context.h"
+#include "upstream-resolver.h"
+
+using asio::ip::tcp;
+
+struct UpstreamConnection
+{
+    UpstreamConnection(asio::io_context& io, asio::ssl::context& tls_context, uint64_t id)
+        : stream(io, tls_context), id(id) {}
+
+    asio::ssl::stream<tcp::socket> stream;
+    const uint64_t id;
+    uint64_t reuse_count = 0;
+    std::chrono::steady_clock::time_point idle_since;
+};
+
+// Process-wide pool of keep-alive TLS connections to the upstream (Binance) host.
+// Sessions borrow a connection for a single request/response exchange and return it
+// when the response has been completely read and the connection may be reused.
+class UpstreamPool
+{
+public:
+    inline static const std::string HOST = "api.binance.com";
+    inline static const std::string PORT = "443";
+
+    struct Options
+    {
+        size_t min_size = 2;                   // connections kept warm
+        size_t max_size = 32;                  // idle connections retained
+        std::chrono::seconds idle_timeout{30}; // idle connections older than this are evicted
+        std::chrono::seconds dns_ttl{60};      // upstream endpoints refresh interval
+        std::chrono::milliseconds connect_stagger{250}; // delay between racing connect attempts
+    };
+
+    using ConnectionPtr = std::shared_ptr<UpstreamConnection>;
+    using ConnectHandler = std::function<void(const asio::error_code&, ConnectionPtr)>;
+
+    UpstreamPool(asio::io_context& io, TlsClientContext& tls_context, Options options);
+
+    void start();
+    void stop();
+
+    // borrows an idle connection or establishes a new one,
+    // the handler is invoked on its associated executor
+    template <typename Handler>
+    void acquire(Handler&& handler)
+    {
+        acquire_impl(wrap_handler(std::forward<Handler>(handler)), true);
+    }
+
+    // establishes a new connection bypassing idle ones
+    template <typename Handler>
+    void connect(Handler&& handler)
+    {
+        acquire_impl(wrap_handler(std::forward<Handler>(handler)), false);
+    }
+
+    // returns a connection which is ready for the next request
+    void release(ConnectionPtr connection);
+
+private:
+    template <typename Handler>
+    ConnectHandler wrap_handler(Handler&& handler)
+    {
+        auto executor = asio::get_associated_executor(handler, io_.get_executor());
+        auto allocator = asio::get_associated_allocator(handler);
+        return [executor, allocator, handler = std::forward<Handler>(handler)](const asio::error_code& ec,
+                                                                               ConnectionPtr connection) mutable
+        {
+            asio::dispatch(executor, asio::bind_allocator(allocator, [handler, ec, connection]() mutable
+                                                          { handler(ec, std::move(connection)); }));
+        };
+    }
+
+    bool init_ssl(UpstreamConnection& connection);
+    void acquire_impl(ConnectHandler handler, bool reuse);
+    ConnectionPtr take_idle();
+    void establish(ConnectHandler handler);
+    void warm_up();
+    void schedule_maintenance();
+    void evict_expired();
+    void close(UpstreamConnection& connection);
+
+private:
+    asio::io_context& io_;
+    Options options_;
+    TlsClientContext& tls_context_;
+    UpstreamResolver resolver_;
+    EndpointScores endpoint_scores_;
+    asio::strand<asio::any_io_executor> strand_;
+    asio::steady_timer maintenance_timer_;
+    std::mutex mutex_;
+    std::deque<ConnectionPtr> idle_; // the most recently released at the back
+    size_t warming_ = 0;
+    std::chrono::steady_clock::time_point warm_up_retry_after_;
+    bool stopped_ = false;
+    std::atomic<uint64_t> connection_id_gen_{1};
+};
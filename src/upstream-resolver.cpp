@@ -0,0 +1,154 @@
+#include "upstream-resolver.h"
+
+#include <algorithm>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+
+UpstreamResolver::UpstreamResolver(asio::io_context& io, std::string host, std::string port,
+                                   std::chrono::seconds ttl)
+    : host_(std::move(host)), port_(std::move(port)), ttl_(ttl),
+      strand_(asio::make_strand(io.get_executor())), resolver_(strand_), refresh_timer_(strand_) {}
+
+void UpstreamResolver::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = true;
+        if (resolving_)
+            return;
+        resolving_ = true;
+    }
+    asio::post(strand_, [this]()
+               { refresh(); });
+}
+
+void UpstreamResolver::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    asio::post(strand_, [this]()
+               {
+                   refresh_timer_.cancel();
+                   resolver_.cancel();
+               });
+}
+
+void UpstreamResolver::resolve(ResolveHandler handler)
+{
+    Endpoints endpoints;
+    bool refresh_required(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (endpoints_)
+        {
+            endpoints = endpoints_;
+            // without background refreshing (single-request mode) an expired entry
+            // is still served while a refresh is started
+            refresh_required = !started_ && !resolving_ &&
+                               (std::chrono::steady_clock::now() - resolved_at_ >= ttl_);
+        }
+        else
+        {
+            waiters_.push_back(std::move(handler));
+            refresh_required = !resolving_;
+        }
+        if (refresh_required)
+            resolving_ = true;
+    }
+
+    if (refresh_required)
+        asio::post(strand_, [this]()
+                   { refresh(); });
+
+    if (endpoints)
+        handler({}, std::move(endpoints));
+}
+
+// expects resolving_ to be set by the caller
+void UpstreamResolver::refresh()
+{
+    resolver_.async_resolve(host_, port_,
+                            [this](const asio::error_code& ec, tcp::resolver::results_type results)
+                            {
+                                on_resolved(ec, results);
+                            });
+}
+
+void UpstreamResolver::on_resolved(const asio::error_code& resolve_ec, const tcp::resolver::results_type& results)
+{
+    // a resolution without any address fails like an error, the last known endpoints are kept
+    const asio::error_code ec = (!resolve_ec && results.empty()) ? asio::error::host_not_found : resolve_ec;
+
+    std::vector<ResolveHandler> waiters;
+    Endpoints endpoints;
+    bool reschedule(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resolving_ = false;
+
+        if (!ec)
+        {
+            std::vector<tcp::endpoint> endpoints;
+            for (const auto& entry : results)
+                if (std::find(endpoints.begin(), endpoints.end(), entry.endpoint()) == endpoints.end())
+                    endpoints.push_back(entry.endpoint());
+
+            endpoints_ = std::make_shared<const std::vector<tcp::endpoint>>(std::move(endpoints));
+            resolved_at_ = std::chrono::steady_clock::now();
+            gl_stats.dns_resolutions.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (ec != asio::error::operation_aborted)
+        {
+            gl_stats.dns_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        endpoints = endpoints_;
+        waiters.swap(waiters_);
+        reschedule = started_ && !stopped_;
+    }
+
+    if (ec)
+    {
+        if (endpoints)
+            gl_logger->warn("UpstreamResolver, {} resolution failure: {}, last known endpoints kept",
+                            host_, ec.message());
+        else
+            gl_logger->error("UpstreamResolver, {} resolution failure: {}", host_, ec.message());
+    }
+    else
+    {
+        gl_logger->debug("UpstreamResolver, {} resolved, endpoints: {}", host_, endpoints->size());
+    }
+
+    for (auto& waiter : waiters)
+    {
+        if (endpoints)
+            waiter({}, endpoints);
+        else
+            waiter(ec, nullptr);
+    }
+
+    if (reschedule)
+        schedule_refresh(!ec ? std::chrono::steady_clock::duration(ttl_) : retry_interval);
+}
+
+void UpstreamResolver::schedule_refresh(std::chrono::steady_clock::duration after)
+{
+    refresh_timer_.expires_after(after);
+    refresh_timer_.async_wait([this](const asio::error_code& ec)
+                              {
+                                  if (ec == asio::error::operation_aborted)
+                                      return;
+                                  {
+                                      std::lock_guard<std::mutex> lock(mutex_);
+                                      if (resolving_ || stopped_)
+                                          return;
+                                      resolving_ = true;
+                                  }
+                                  refresh();
+                              });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using asio::ip::tcp;
+
+// Cached resolution of the upstream host.
+// Endpoints are refreshed in the background every TTL, so connections never wait
+// for DNS except the very first one; the last known endpoints keep being served
+// when a refresh fails.
+class UpstreamResolver
+{
+    constexpr static auto retry_interval = std::chrono::seconds(5);
+
+public:
+    using Endpoints = std::shared_ptr<const std::vector<tcp::endpoint>>;
+    using ResolveHandler = std::function<void(const asio::error_code&, Endpoints)>;
+
+    UpstreamResolver(asio::io_context& io, std::string host, std::string port, std::chrono::seconds ttl);
+
+    void start();
+    void stop();
+
+    // provides cached endpoints, waits for a resolution only if nothing has been resolved yet
+    void resolve(ResolveHandler handler);
+
+protected:
+    void on_resolved(const asio::error_code& resolve_ec, const tcp::resolver::results_type& results);
+
+private:
+    void refresh();
+    void schedule_refresh(std::chrono::steady_clock::duration after);
+
+private:
+    const std::string host_;
+    const std::string port_;
+    const std::chrono::seconds ttl_;
+    asio::strand<asio::any_io_executor> strand_;
+    tcp::resolver resolver_;
+    asio::steady_timer refresh_timer_;
+    std::mutex mutex_;
+    Endpoints endpoints_;
+    std::chrono::steady_clock::time_point resolved_at_;
+    std::vector<ResolveHandler> waiters_;
+    bool resolving_ = false;
+    bool started_ = false;
+    bool stopped_ = false;
+};
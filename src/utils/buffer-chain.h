@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Chain of fixed-size refcounted blocks holding a response.
+// Upstream reads fill the free space of the tail block directly, and the
+// client write sends all blocks at once (scatter/gather), so the relayed
+// bytes are never copied between intermediate buffers.
+class BufferChain
+{
+public:
+    constexpr static size_t block_size = 16 * 1024;
+
+    struct Block
+    {
+        std::array<char, block_size> data;
+        size_t size = 0;
+    };
+
+    // free space of the tail block, a new block is appended if it is full
+    asio::mutable_buffer prepare()
+    {
+        if (blocks_.empty() || (blocks_.back()->size == block_size))
+            blocks_.push_back(std::make_shared<Block>());
+
+        Block& tail = *blocks_.back();
+        return asio::buffer(tail.data.data() + tail.size, block_size - tail.size);
+    }
+
+    // makes n bytes of the prepared space part of the chain
+    void commit(size_t n)
+    {
+        blocks_.back()->size += n;
+        size_ += n;
+    }
+
+    void append(const char* data, size_t n)
+    {
+        while (n > 0)
+        {
+            auto space = prepare();
+            const size_t part = (n < space.size()) ? n : space.size();
+            std::memcpy(space.data(), data, part);
+            commit(part);
+            data += part;
+            n -= part;
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // buffer sequence for gathered writes
+    std::vector<asio::const_buffer> buffers() const
+    {
+        std::vector<asio::const_buffer> result;
+        result.reserve(blocks_.size());
+        for (const auto& block : blocks_)
+            if (block->size > 0)
+                result.emplace_back(block->data.data(), block->size);
+        return result;
+    }
+
+    std::string to_string() const
+    {
+        std::string result;
+        result.reserve(size_);
+        for (const auto& block : blocks_)
+            result.append(block->data.data(), block->size);
+        return result;
+    }
+
+private:
+    std::vector<std::shared_ptr<Block>> blocks_;
+    size_t size_ = 0;
+};
+
+using SharedBufferChain = std::shared_ptr<const BufferChain>;
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+// CPUs granted by a cgroup v2 "cpu.max" ("<quota> <period>" or "max <period>"),
+// nullopt if unlimited or malformed
+inline std::optional<double> parse_cgroup_cpu_max(std::string_view text)
+{
+    const auto space = text.find(' ');
+    if ((space == std::string_view::npos) || (text.substr(0, space) == "max"))
+        return std::nullopt;
+
+    const std::string quota(text.substr(0, space)), period(text.substr(space + 1));
+    const double q = std::atof(quota.c_str()), p = std::atof(period.c_str());
+    if ((q <= 0) || (p <= 0))
+        return std::nullopt;
+    return q / p;
+}
+
+// CPU limit of the process' cgroup (container quota), nullopt if there is none
+inline std::optional<double> cgroup_cpu_limit()
+{
+#ifdef __linux__
+    std::optional<double> limit;
+    auto apply = [&limit](std::optional<double> value)
+    {
+        if (value && (!limit || (*value < *limit)))
+            limit = value;
+    };
+
+    // cgroup v2: the process' group and its ancestors ("0::/<path>" in /proc/self/cgroup)
+    std::ifstream cgroups("/proc/self/cgroup");
+    for (std::string line; std::getline(cgroups, line);)
+    {
+        if (line.rfind("0::", 0) != 0)
+            continue;
+
+        std::string path = line.substr(3);
+        while (true)
+        {
+            std::ifstream cpu_max("/sys/fs/cgroup" + path + "/cpu.max");
+            std::string text;
+            if (std::getline(cpu_max, text))
+                apply(parse_cgroup_cpu_max(text));
+
+            if (path.empty() || (path == "/"))
+                break;
+            path.erase(path.rfind('/'));
+        }
+    }
+
+    // cgroup v1
+    std::ifstream quota("/sys/fs/cgroup/cpu/cpu.cfs_quota_us"), period("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    long long q(0), p(0);
+    if ((quota >> q) && (period >> p) && (q > 0) && (p > 0))
+        apply(static_cast<double>(q) / static_cast<double>(p));
+
+    return limit;
+#else
+    return std::nullopt;
+#endif
+}
+
+// CPUs the process is allowed to run on
+inline std::vector<unsigned> allowed_cpus()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+#endif
+    if (cpus.empty())
+        for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++)
+            cpus.push_back(cpu);
+    return cpus;
+}
+
+// one thread per CPU the process can actually use
+inline size_t default_thread_count()
+{
+    size_t cpus = allowed_cpus().size();
+    if (auto limit = cgroup_cpu_limit())
+        cpus = std::min(cpus, static_cast<size_t>(std::ceil(*limit)));
+    return std::max<size_t>(cpus, 1);
+}
+
+inline bool pin_current_thread(unsigned cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    return (cpu < 64) && (SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0);
+#else
+    return false;
+#endif
+}
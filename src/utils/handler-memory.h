@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "common/stats.h"
+
+// Small-block arena for the completion handlers of one session: the asynchronous
+// operations it has in flight at a time are few, their memory is taken from the arena
+// instead of the heap. An operation may be started on one io thread and release its
+// memory on another, blocks are claimed and returned atomically.
+// Larger operations, or more of them than there are blocks, fall back to the heap.
+class HandlerMemory
+{
+public:
+    constexpr static size_t block_size = 512;
+    constexpr static size_t block_count = 6;
+
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    void* allocate(size_t size)
+    {
+        if (size <= block_size)
+        {
+            for (size_t i = 0; i < block_count; i++)
+                if (!in_use_[i].load(std::memory_order_relaxed) && !in_use_[i].exchange(true, std::memory_order_acquire))
+                    return blocks_[i].data;
+        }
+
+        gl_stats.handler_memory_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        const auto address = reinterpret_cast<uintptr_t>(p);
+        const auto first = reinterpret_cast<uintptr_t>(blocks_.data());
+        if ((address >= first) && (address < first + sizeof(blocks_)))
+        {
+            in_use_[(address - first) / sizeof(Block)].store(false, std::memory_order_release);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+private:
+    struct alignas(std::max_align_t) Block
+    {
+        unsigned char data[block_size];
+    };
+
+    std::array<Block, block_count> blocks_;
+    std::array<std::atomic<bool>, block_count> in_use_{};
+};
+
+// associated allocator of a session's completion handlers (asio::bind_allocator)
+template <typename T>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& memory) noexcept : memory_(&memory) {}
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept : memory_(other.memory_) {}
+
+    T* allocate(size_t n)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned operations aren't supported");
+        return static_cast<T*>(memory_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept
+    {
+        memory_->deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U>& other) const noexcept { return memory_ == other.memory_; }
+    template <typename U>
+    bool operator!=(const HandlerAllocator<U>& other) const noexcept { return memory_ != other.memory_; }
+
+private:
+    template <typename>
+    friend class HandlerAllocator;
+
+    HandlerMemory* memory_;
+};
+
+// completion handler invoked through the executor, its operations allocated from the handler memory
+template <typename Executor, typename Handler>
+auto bind_with_memory(const Executor& executor, HandlerMemory& memory, Handler&& handler)
+{
+    return asio::bind_executor(executor,
+                               asio::bind_allocator(HandlerAllocator<char>(memory), std::forward<Handler>(handler)));
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <immintrin.h>
+#define MB_SCAN_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Vectorized search of the delimiters of HTTP heads (line feeds, colons): the positions of
+// all the delimiters of a 16 or 32 bytes block are found with a few vector compares, then
+// visited from a bit mask. Shared by the request parser and the response framer.
+// The instruction set is chosen at compile time: AVX2 (-DMB_AVX2=ON), SSE2 (x86-64)
+// or a byte by byte loop elsewhere.
+enum class ScanIsa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+#if defined(__AVX2__)
+inline constexpr ScanIsa native_scan_isa = ScanIsa::Avx2;
+#elif defined(MB_SCAN_SSE2)
+inline constexpr ScanIsa native_scan_isa = ScanIsa::Sse2;
+#else
+inline constexpr ScanIsa native_scan_isa = ScanIsa::Scalar;
+#endif
+
+inline constexpr const char* scan_isa_name(ScanIsa isa)
+{
+    return (isa == ScanIsa::Avx2) ? "avx2" : (isa == ScanIsa::Sse2) ? "sse2" : "scalar";
+}
+
+namespace header_scanner
+{
+    inline unsigned lowest_bit(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // bit i of mask() is set if byte i of the block is one of the delimiters
+    template <ScanIsa isa, char... Delimiters>
+    struct Block;
+
+#ifdef MB_SCAN_SSE2
+    template <char... Delimiters>
+    struct Block<ScanIsa::Sse2, Delimiters...>
+    {
+        constexpr static size_t width = 16;
+
+        static uint32_t mask(const char* data)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i found = _mm_setzero_si128();
+            ((found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(Delimiters)))), ...);
+            return static_cast<uint32_t>(_mm_movemask_epi8(found));
+        }
+    };
+#endif
+
+#ifdef __AVX2__
+    template <char... Delimiters>
+    struct Block<ScanIsa::Avx2, Delimiters...>
+    {
+        constexpr static size_t width = 32;
+
+        static uint32_t mask(const char* data)
+        {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i found = _mm256_setzero_si256();
+            ((found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(Delimiters)))), ...);
+            return static_cast<uint32_t>(_mm256_movemask_epi8(found));
+        }
+    };
+#endif
+}
+
+// calls on_delimiter(position) for each of the Delimiters in data[from, size), in order,
+// until it returns false; returns the position following the last delimiter visited
+// or size if the scan has reached the end
+template <ScanIsa isa, char... Delimiters, typename OnDelimiter>
+size_t scan_delimiters(const char* data, size_t from, size_t size, OnDelimiter&& on_delimiter)
+{
+    size_t pos = from;
+
+    if constexpr (isa != ScanIsa::Scalar)
+    {
+        using Block = header_scanner::Block<isa, Delimiters...>;
+        for (; pos + Block::width <= size; pos += Block::width)
+        {
+            for (uint32_t mask = Block::mask(data + pos); mask != 0; mask &= mask - 1)
+            {
+                const size_t found = pos + header_scanner::lowest_bit(mask);
+                if (!on_delimiter(found))
+                    return found + 1;
+            }
+        }
+    }
+
+    // the tail shorter than a block
+    for (; pos < size; pos++)
+        if (((data[pos] == Delimiters) || ...) && !on_delimiter(pos))
+            return pos + 1;
+    return size;
+}
+
+// end of the "\r\n\r\n" terminated head in data[0, size) (past the terminator) looking
+// at the bytes from `from` on, npos if it isn't there yet
+template <ScanIsa isa = native_scan_isa>
+size_t find_header_end(const char* data, size_t from, size_t size)
+{
+    size_t end = std::string_view::npos;
+    scan_delimiters<isa, '\n'>(data, from, size,
+                               [&](size_t pos)
+                               {
+                                   if ((pos < 3) || (data[pos - 1] != '\r') || (data[pos - 2] != '\n') ||
+                                       (data[pos - 3] != '\r'))
+                                       return true;
+                                   end = pos + 1;
+                                   return false;
+                               });
+    return end;
+}
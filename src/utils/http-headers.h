@@ -0,0 +1,266 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "utils/small-vector.h"
+
+constexpr char ascii_lower(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// case-insensitive comparison (header names, tokens)
+constexpr bool iequals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (ascii_lower(a[i]) != ascii_lower(b[i]))
+            return false;
+    return true;
+}
+
+// header fields the proxy looks at, resolved once by name (when parsed or set)
+enum class HeaderId : uint8_t
+{
+    Host,
+    UserAgent,
+    Connection,
+    ContentLength,
+    ContentType,
+    AcceptEncoding,
+    XMbxApiKey,
+    Other
+};
+
+inline constexpr size_t well_known_header_count = static_cast<size_t>(HeaderId::Other);
+
+// at least 4 and at most 16 characters (header_id() compares them as words)
+inline constexpr std::array<std::string_view, well_known_header_count> well_known_header_names = {
+    "Host", "User-Agent", "Connection", "Content-Length", "Content-Type", "Accept-Encoding", "X-MBX-APIKEY"};
+
+constexpr std::string_view header_name(HeaderId id)
+{
+    return well_known_header_names[static_cast<size_t>(id)];
+}
+
+namespace header_hash
+{
+    constexpr size_t table_size = 8;
+
+    // perfect on the well-known names (checked below): their length and first letter
+    constexpr size_t slot(std::string_view name)
+    {
+        return (name.size() * 7 + (static_cast<unsigned char>(ascii_lower(name[0])) >> 3)) % table_size;
+    }
+
+    constexpr std::array<HeaderId, table_size> make_table()
+    {
+        std::array<HeaderId, table_size> table{};
+        for (size_t i = 0; i < table_size; i++)
+            table[i] = HeaderId::Other;
+        for (size_t i = 0; i < well_known_header_count; i++)
+            table[slot(well_known_header_names[i])] = static_cast<HeaderId>(i);
+        return table;
+    }
+
+    inline constexpr std::array<HeaderId, table_size> table = make_table();
+
+    constexpr bool perfect()
+    {
+        for (size_t i = 0; i < well_known_header_count; i++)
+            if (table[slot(well_known_header_names[i])] != static_cast<HeaderId>(i))
+                return false;
+        return true;
+    }
+
+    static_assert(perfect(), "well-known header names share a slot, adjust slot()");
+
+    // a well-known name lowercased, and 0x20 where it has a letter
+    struct Key
+    {
+        char lower[16];
+        char letters[16];
+    };
+
+    constexpr std::array<Key, well_known_header_count> make_keys()
+    {
+        std::array<Key, well_known_header_count> keys{};
+        for (size_t i = 0; i < well_known_header_count; i++)
+        {
+            const std::string_view name = well_known_header_names[i];
+            for (size_t j = 0; j < name.size(); j++)
+            {
+                keys[i].lower[j] = ascii_lower(name[j]);
+                keys[i].letters[j] = ((keys[i].lower[j] >= 'a') && (keys[i].lower[j] <= 'z')) ? 0x20 : 0;
+            }
+        }
+        return keys;
+    }
+
+    inline constexpr std::array<Key, well_known_header_count> keys = make_keys();
+
+    constexpr bool word_sized()
+    {
+        for (const std::string_view name : well_known_header_names)
+            if ((name.size() < 4) || (name.size() > sizeof(Key::lower)))
+                return false;
+        return true;
+    }
+
+    static_assert(word_sized(), "well-known header names are compared as 4 to 16 bytes");
+
+    // first and last 8 (or 4) bytes, overlapping for the shorter names
+    template <typename Word>
+    inline bool equal_words(const char* name, const char* lower, const char* letters, size_t size)
+    {
+        Word a[2], k[2], m[2];
+        std::memcpy(&a[0], name, sizeof(Word));
+        std::memcpy(&a[1], name + size - sizeof(Word), sizeof(Word));
+        std::memcpy(&k[0], lower, sizeof(Word));
+        std::memcpy(&k[1], lower + size - sizeof(Word), sizeof(Word));
+        std::memcpy(&m[0], letters, sizeof(Word));
+        std::memcpy(&m[1], letters + size - sizeof(Word), sizeof(Word));
+        return (((a[0] | m[0]) ^ k[0]) | ((a[1] | m[1]) ^ k[1])) == 0;
+    }
+
+    // case-insensitive comparison with a well-known name, without a loop over the bytes:
+    // the letters are lowered by setting their 0x20 bit, the other bytes compared as they are
+    inline bool matches(std::string_view name, HeaderId id)
+    {
+        const Key& key = keys[static_cast<size_t>(id)];
+        if (name.size() != header_name(id).size())
+            return false;
+        if (name.size() >= 8)
+            return equal_words<uint64_t>(name.data(), key.lower, key.letters, name.size());
+        return equal_words<uint32_t>(name.data(), key.lower, key.letters, name.size());
+    }
+}
+
+// id of a header name (case-insensitive), one hash and one comparison
+inline HeaderId header_id(std::string_view name)
+{
+    if (name.empty())
+        return HeaderId::Other;
+    const HeaderId id = header_hash::table[header_hash::slot(name)];
+    return ((id != HeaderId::Other) && header_hash::matches(name, id)) ? id : HeaderId::Other;
+}
+
+// Header fields of a request or a response: the names and values back to back in one string,
+// the fields in a small vector kept inline, the well-known ones found by id without a search.
+// Setting a field replaces the value of one with the same (case-insensitive) name.
+class HttpHeaders
+{
+public:
+    constexpr static size_t inline_fields = 16;
+
+    size_t size() const { return fields_.size(); }
+    bool empty() const { return fields_.empty(); }
+
+    HeaderId id(size_t i) const { return fields_[i].id; }
+    std::string_view name(size_t i) const { return view(fields_[i].name_offset, fields_[i].name_size); }
+    std::string_view value(size_t i) const { return view(fields_[i].value_offset, fields_[i].value_size); }
+
+    std::optional<std::string_view> find(HeaderId id) const
+    {
+        if (id == HeaderId::Other)
+            return std::nullopt;
+        const uint16_t position = well_known_[static_cast<size_t>(id)];
+        if (position == 0)
+            return std::nullopt;
+        return value(position - 1);
+    }
+
+    std::optional<std::string_view> find(std::string_view name) const
+    {
+        const size_t i = position(header_id(name), name);
+        if (i == size())
+            return std::nullopt;
+        return value(i);
+    }
+
+    void set(std::string_view name, std::string_view value)
+    {
+        set(header_id(name), name, value);
+    }
+
+    void set(HeaderId id, std::string_view value)
+    {
+        set(id, header_name(id), value);
+    }
+
+    // name already resolved to its id (by the request parser)
+    void set(HeaderId id, std::string_view name, std::string_view value)
+    {
+        const size_t i = position(id, name);
+        if (i < size())
+        {
+            Field& field = fields_[i];
+            field.value_offset = static_cast<uint32_t>(text_.size());
+            field.value_size = static_cast<uint32_t>(value.size());
+            text_.append(value);
+            return;
+        }
+
+        const auto offset = static_cast<uint32_t>(text_.size());
+        text_.append(name).append(value);
+        fields_.push_back({offset, static_cast<uint32_t>(offset + name.size()), static_cast<uint32_t>(value.size()),
+                           static_cast<uint16_t>(name.size()), id});
+        if (id != HeaderId::Other)
+            well_known_[static_cast<size_t>(id)] = static_cast<uint16_t>(size());
+    }
+
+    // bytes of the names and values to be set
+    void reserve(size_t text_size)
+    {
+        text_.reserve(text_size);
+    }
+
+    void clear()
+    {
+        text_.clear();
+        fields_.clear();
+        well_known_ = {};
+    }
+
+private:
+    struct Field
+    {
+        uint32_t name_offset;
+        uint32_t value_offset;
+        uint32_t value_size;
+        uint16_t name_size;
+        HeaderId id;
+    };
+
+    std::string_view view(uint32_t offset, uint32_t size) const
+    {
+        return std::string_view(text_).substr(offset, size);
+    }
+
+    // index of the field, size() if absent
+    size_t position(HeaderId id, std::string_view name) const
+    {
+        if (id != HeaderId::Other)
+        {
+            const uint16_t position = well_known_[static_cast<size_t>(id)];
+            return (position == 0) ? size() : position - 1;
+        }
+
+        for (size_t i = 0; i < size(); i++)
+            if ((fields_[i].id == HeaderId::Other) && iequals(this->name(i), name))
+                return i;
+        return size();
+    }
+
+private:
+    std::string text_;
+    SmallVector<Field, inline_fields> fields_;
+    std::array<uint16_t, well_known_header_count> well_known_{}; // field index + 1, 0 if absent
+};
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <asio.hpp>
-#include <map>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/http-headers.h"
 
 enum class HTTPResponseCodes : long
 {
@@ -12,16 +18,32 @@ enum class HTTPResponseCodes : long
     BadRequest = 400,
     Unauthorized = 401,
     Forbidden = 403,
-    NotFound = 404
+    NotFound = 404,
+    BadGateway = 502
 };
 
-inline constexpr auto http_request_headers_delimiter = "\r\n\r\n";
-
 inline bool is_http_status_ok(long status)
 {
     return (static_cast<long>(HTTPResponseCodes::OK) == status);
 }
 
+inline std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && ((s.front() == ' ') || (s.front() == '\t')))
+        s.remove_prefix(1);
+    while (!s.empty() && ((s.back() == ' ') || (s.back() == '\t')))
+        s.remove_suffix(1);
+    return s;
+}
+
+inline bool icontains(std::string_view s, std::string_view token)
+{
+    for (size_t i = 0; i + token.size() <= s.size(); i++)
+        if (iequals(s.substr(i, token.size()), token))
+            return true;
+    return false;
+}
+
 struct UrlEntry
 {
     std::string original;
@@ -34,7 +56,7 @@ struct HttpRequest
     std::string method;
     std::string target;
     std::string version;
-    std::map<std::string, std::string> headers;
+    HttpHeaders headers;
     std::string body;
 };
 
@@ -42,7 +64,7 @@ struct HttpResponse
 {
     int status_code = static_cast<long>(HTTPResponseCodes::OK);
     std::string reason = "OK";
-    std::map<std::string, std::string> headers;
+    HttpHeaders headers;
     std::string body;
 
     std::string to_string() const
@@ -51,9 +73,9 @@ struct HttpResponse
 
         std::ostringstream oss;
         oss << "HTTP/1.1 " << status_code << " " << reason << rn;
-        for (auto const& kv : headers)
+        for (size_t i = 0; i < headers.size(); i++)
         {
-            oss << kv.first << ": " << kv.second << rn;
+            oss << headers.name(i) << ": " << headers.value(i) << rn;
         }
         oss << "Content-Length: " << body.size() << rn;
         oss << rn;
@@ -62,49 +84,83 @@ struct HttpResponse
     }
 };
 
-inline HttpRequest parse_request(const std::string& raw)
+// case-insensitive header lookup, nullopt if absent
+inline std::optional<std::string_view> find_header(const HttpRequest& request, std::string_view name)
 {
-    HttpRequest req;
-    std::istringstream iss(raw);
-    std::string line;
+    return request.headers.find(name);
+}
 
-    // Request line
-    if (!std::getline(iss, line))
-    {
-        return req;
-    }
-    if (!line.empty() && line.back() == '\r')
-        line.pop_back();
+// persistent connection semantics of HTTP/1.1 (RFC 9112, 9.3)
+inline bool is_keep_alive(const HttpRequest& request)
+{
+    const auto connection = request.headers.find(HeaderId::Connection);
+    if (request.version == "HTTP/1.1")
+        return !connection || !icontains(*connection, "close");
+    return connection && icontains(*connection, "keep-alive");
+}
+
+// a request followed by a body (its Content-Length validated by the request parser)
+inline bool has_body(const HttpRequest& request)
+{
+    const auto length = request.headers.find(HeaderId::ContentLength);
+    return length && (length->find_first_not_of('0') != std::string_view::npos);
+}
+
+// the connection may carry another request after this one: a body isn't read (the upstream
+// request is a GET without one), the bytes following the head are never taken for the next request,
+// and a HEAD is answered with the body of a GET, the client would take it for the next response
+inline bool allows_next_request(const HttpRequest& request)
+{
+    return !has_body(request) && (request.method != "HEAD");
+}
+
+// path part of a request target
+inline std::string_view target_path(std::string_view target)
+{
+    return target.substr(0, target.find('?'));
+}
+
+// request target with the query parameters in a canonical order,
+// targets differing only in the parameter order are equal once normalized
+inline std::string normalize_target(std::string_view target)
+{
+    const auto query_pos = target.find('?');
+    if (query_pos == std::string_view::npos)
+        return std::string(target);
+
+    std::vector<std::string_view> params;
+    std::string_view query = target.substr(query_pos + 1);
+    while (!query.empty())
     {
-        std::istringstream rl(line);
-        rl >> req.method >> req.target >> req.version;
+        const auto end = query.find('&');
+        std::string_view param = query.substr(0, end);
+        if (!param.empty())
+            params.push_back(param);
+        query.remove_prefix((end == std::string_view::npos) ? query.size() : end + 1);
     }
+    std::sort(params.begin(), params.end());
 
-    // Headers
-    while (std::getline(iss, line))
+    std::string result(target.substr(0, query_pos));
+    for (size_t i = 0; i < params.size(); i++)
     {
-        if (!line.empty() && line.back() == '\r')
-            line.pop_back();
-        if (line.empty())
-            break; // end of headers
-        auto pos = line.find(':');
-        if (pos != std::string::npos)
-        {
-            std::string name = line.substr(0, pos);
-            std::string value = line.substr(pos + 1);
-            // trim leading spaces
-            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
-            {
-                value.erase(value.begin());
-            }
-            req.headers[name] = value;
-        }
+        result += (i == 0) ? '?' : '&';
+        result += params[i];
     }
+    return result;
+}
 
-    // Body (rest of stream)
-    std::string body;
-    std::getline(iss, body, '\0');
-    req.body = body;
+// request forwarded upstream for a client request (both session engines)
+inline std::string format_upstream_request(const HttpRequest& request, std::string_view host)
+{
+    const std::string_view user_agent = request.headers.find(HeaderId::UserAgent).value_or("market-bridge/1.0.0");
 
-    return req;
+    std::string result;
+    result.reserve(request.target.size() + host.size() + user_agent.size() + 96);
+    result.append("GET ").append(request.target).append(" HTTP/1.1\r\n");
+    result.append("Host: ").append(host).append("\r\n");
+    result.append("User-Agent: ").append(user_agent).append("\r\n");
+    result.append("Accept: */*\r\n");
+    result.append("Connection: keep-alive\r\n");
+    result.append("\r\n");
+    return result;
 }
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "utils/header-scanner.h"
+#include "utils/http-headers.h"
+#include "utils/http-helper.h"
+
+// Incremental HTTP/1.x request head parser.
+// Parses the request line and the header fields in place: the received bytes aren't copied,
+// the parsed parts are string_views into them. Called again as more bytes arrive, it resumes
+// where it stopped. The line feeds and colons are found in a single pass of the vectorized
+// header scanner. The parts are kept as offsets, the receive buffer may move between
+// the calls (a growing streambuf).
+// A body is framed by a single Content-Length only: transfer codings and repeated lengths
+// can't be told apart from the next request reliably, such requests are rejected.
+class HttpRequestParser
+{
+public:
+    enum class Status
+    {
+        Incomplete, // more bytes are needed
+        Complete,   // the head ends at size()
+        Error       // malformed, too large or framed otherwise than by a single Content-Length
+    };
+
+    constexpr static size_t max_header_size = 64 * 1024;
+    constexpr static size_t max_headers = 64;
+
+    // the header fields aren't cleared, only the first header_count() are in use
+    void reset()
+    {
+        data_ = nullptr;
+        line_ = 0;
+        colon_ = std::string_view::npos;
+        scanned_ = 0;
+        size_ = 0;
+        status_ = Status::Incomplete;
+        request_line_done_ = false;
+        method_ = target_ = version_ = Span();
+        header_count_ = 0;
+        well_known_ = {};
+        content_length_ = 0;
+    }
+
+    // data: the bytes received so far, starting with the request (and growing between the calls)
+    template <ScanIsa isa = native_scan_isa>
+    Status parse(std::string_view data)
+    {
+        data_ = data.data();
+        if (status_ != Status::Incomplete)
+            return status_;
+
+        // line feeds and colons in a single pass, the first colon of a line ends the field name
+        const size_t limit = (data.size() < max_header_size) ? data.size() : max_header_size;
+        scanned_ = scan_delimiters<isa, '\n', ':'>(data.data(), scanned_, limit,
+                                                   [&](size_t pos)
+                                                   {
+                                                       if (data[pos] == ':')
+                                                       {
+                                                           if (colon_ == std::string_view::npos)
+                                                               colon_ = pos;
+                                                           return true;
+                                                       }
+                                                       on_line_end(data, pos);
+                                                       return status_ == Status::Incomplete;
+                                                   });
+
+        if ((status_ == Status::Incomplete) && (data.size() > max_header_size))
+            status_ = Status::Error;
+        return status_;
+    }
+
+    Status status() const { return status_; }
+    // bytes of the request head (the request line, header fields and the empty line) once complete
+    size_t size() const { return size_; }
+    // bytes scanned so far
+    size_t parsed() const { return scanned_; }
+    // bytes of the body following the head, 0 without a Content-Length
+    size_t content_length() const { return content_length_; }
+
+    std::string_view method() const { return view(method_); }
+    std::string_view target() const { return view(target_); }
+    std::string_view version() const { return view(version_); }
+
+    size_t header_count() const { return header_count_; }
+    std::string_view header_name(size_t i) const { return view(headers_[i].name); }
+    std::string_view header_value(size_t i) const { return view(headers_[i].value); }
+    HeaderId header_id(size_t i) const { return headers_[i].id; }
+
+    // the last field of a well-known header, an empty view if absent
+    std::string_view find_header(HeaderId id) const
+    {
+        const uint8_t position = (id == HeaderId::Other) ? 0 : well_known_[static_cast<size_t>(id)];
+        return (position == 0) ? std::string_view() : header_value(position - 1);
+    }
+
+    // case-insensitive header lookup (the last field of the name), an empty view if absent
+    std::string_view find_header(std::string_view name) const
+    {
+        if (const HeaderId id = ::header_id(name); id != HeaderId::Other)
+            return find_header(id);
+        for (size_t i = header_count_; i > 0; i--)
+            if (iequals(header_name(i - 1), name))
+                return header_value(i - 1);
+        return {};
+    }
+
+private:
+    constexpr static size_t max_content_length_digits = 15; // no overflow
+
+    struct Span
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct Field
+    {
+        Span name;
+        Span value;
+        HeaderId id;
+    };
+
+    std::string_view view(Span span) const
+    {
+        return span.size ? std::string_view(data_ + span.offset, span.size) : std::string_view();
+    }
+
+    static Span span(std::string_view data, std::string_view part)
+    {
+        return {static_cast<uint32_t>(part.data() - data.data()), static_cast<uint32_t>(part.size())};
+    }
+
+    void on_line_end(std::string_view data, size_t eol)
+    {
+        size_t end = eol;
+        if ((end > line_) && (data[end - 1] == '\r'))
+            end--;
+        const std::string_view line = data.substr(line_, end - line_);
+        const size_t colon = (colon_ < end) ? colon_ - line_ : std::string_view::npos;
+        line_ = eol + 1;
+        colon_ = std::string_view::npos;
+
+        if (!request_line_done_)
+        {
+            // empty lines preceding the request line are ignored (RFC 9112, 2.2)
+            if (!line.empty())
+                parse_request_line(data, line);
+            return;
+        }
+
+        if (line.empty())
+        {
+            status_ = Status::Complete;
+            size_ = line_;
+            return;
+        }
+
+        const std::string_view name = line.substr(0, (colon == std::string_view::npos) ? 0 : colon);
+        // no whitespace is allowed between the field name and the colon (RFC 9112, 5.1)
+        if (name.empty() || (name.back() == ' ') || (name.back() == '\t') || (header_count_ == max_headers))
+        {
+            status_ = Status::Error;
+            return;
+        }
+
+        // well-known names resolved once, the lookups that follow don't compare strings
+        const HeaderId id = ::header_id(name);
+        const std::string_view value = trim(line.substr(colon + 1));
+        if (!frames_body(id, name, value))
+        {
+            status_ = Status::Error;
+            return;
+        }
+
+        headers_[header_count_++] = {span(data, name), span(data, value), id};
+        if (id != HeaderId::Other)
+            well_known_[static_cast<size_t>(id)] = static_cast<uint8_t>(header_count_);
+    }
+
+    // a single Content-Length of digits, no Transfer-Encoding (RFC 9112, 6.3)
+    bool frames_body(HeaderId id, std::string_view name, std::string_view value)
+    {
+        if (id == HeaderId::Other)
+            return !iequals(name, "Transfer-Encoding");
+        if (id != HeaderId::ContentLength)
+            return true;
+
+        if ((well_known_[static_cast<size_t>(id)] != 0) || value.empty() || (value.size() > max_content_length_digits))
+            return false;
+        for (const char c : value)
+        {
+            if ((c < '0') || (c > '9'))
+                return false;
+            content_length_ = content_length_ * 10 + static_cast<size_t>(c - '0');
+        }
+        return true;
+    }
+
+    // method SP request-target SP HTTP-version
+    void parse_request_line(std::string_view data, std::string_view line)
+    {
+        const size_t first = line.find(' ');
+        const size_t second = (first == std::string_view::npos) ? first : line.find(' ', first + 1);
+        if ((first == 0) || (second == std::string_view::npos) || (second == first + 1) || (second + 1 == line.size()) ||
+            (line.find(' ', second + 1) != std::string_view::npos))
+        {
+            status_ = Status::Error;
+            return;
+        }
+
+        method_ = span(data, line.substr(0, first));
+        target_ = span(data, line.substr(first + 1, second - first - 1));
+        version_ = span(data, line.substr(second + 1));
+        request_line_done_ = true;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t line_ = 0;                       // start of the line being parsed
+    size_t colon_ = std::string_view::npos; // first colon of the line
+    size_t scanned_ = 0;                    // bytes searched for the delimiters
+    size_t size_ = 0;
+    Status status_ = Status::Incomplete;
+    bool request_line_done_ = false;
+    Span method_{};
+    Span target_{};
+    Span version_{};
+    std::array<Field, max_headers> headers_;
+    size_t header_count_ = 0;
+    std::array<uint8_t, well_known_header_count> well_known_{}; // field index + 1, 0 if absent
+    size_t content_length_ = 0;
+};
+
+// request owning its parts, it outlives the receive buffer
+inline HttpRequest make_request(const HttpRequestParser& parser)
+{
+    HttpRequest request;
+    request.method = parser.method();
+    request.target = parser.target();
+    request.version = parser.version();
+
+    size_t text_size = 0;
+    for (size_t i = 0; i < parser.header_count(); i++)
+        text_size += parser.header_name(i).size() + parser.header_value(i).size();
+    request.headers.reserve(text_size);
+    for (size_t i = 0; i < parser.header_count(); i++)
+        request.headers.set(parser.header_id(i), parser.header_name(i), parser.header_value(i));
+    return request;
+}
+
+// parses a whole request (the head and the bytes following it as the body)
+inline HttpRequest parse_request(std::string_view raw)
+{
+    HttpRequestParser parser;
+    if (parser.parse(raw) != HttpRequestParser::Status::Complete)
+        return {};
+
+    HttpRequest request = make_request(parser);
+    request.body = raw.substr(parser.size());
+    return request;
+}
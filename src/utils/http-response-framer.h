@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "utils/header-scanner.h"
+#include "utils/http-helper.h"
+
+// Incremental HTTP/1.x response framer.
+// Tracks message boundaries of a response stream (Content-Length, chunked
+// or read-until-close bodies) without modifying the relayed bytes, so an
+// upstream connection can be reused once the response is complete.
+class HttpResponseFramer
+{
+    enum class State
+    {
+        Header,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailer,
+        UntilClose,
+        Complete,
+        Error
+    };
+
+    constexpr static size_t max_header_size = 64 * 1024;
+
+public:
+    void reset()
+    {
+        *this = HttpResponseFramer();
+    }
+
+    // feeds received bytes, returns the number of bytes belonging to the current response
+    size_t feed(const char* data, size_t size)
+    {
+        size_t pos = 0;
+        while ((pos < size) && (state_ != State::Complete) && (state_ != State::Error))
+        {
+            switch (state_)
+            {
+            case State::Header:
+                pos += feed_header(data + pos, size - pos);
+                break;
+            case State::Body:
+            case State::ChunkData:
+            {
+                size_t n = (size - pos < remaining_) ? size - pos : remaining_;
+                remaining_ -= n;
+                pos += n;
+                if (remaining_ == 0)
+                    state_ = (state_ == State::Body) ? State::Complete : State::ChunkDataEnd;
+                break;
+            }
+            case State::ChunkDataEnd:
+                // CRLF following chunk data
+                if (data[pos++] == '\n')
+                    state_ = State::ChunkSize;
+                break;
+            case State::ChunkSize:
+                pos += feed_chunk_size(data + pos, size - pos);
+                break;
+            case State::Trailer:
+                pos += feed_trailer(data + pos, size - pos);
+                break;
+            case State::UntilClose:
+                pos = size;
+                break;
+            default:
+                break;
+            }
+        }
+        return pos;
+    }
+
+    bool complete() const { return state_ == State::Complete; }
+    bool failed() const { return state_ == State::Error; }
+    bool reads_until_close() const { return state_ == State::UntilClose; }
+    bool headers_received() const { return state_ != State::Header; }
+    bool keep_alive() const { return keep_alive_ && !reads_until_close(); }
+    int status_code() const { return status_code_; }
+
+private:
+    size_t feed_header(const char* data, size_t size)
+    {
+        const size_t search_from = (header_.size() > 3) ? header_.size() - 3 : 0;
+        header_.append(data, size);
+
+        const size_t header_length = find_header_end(header_.data(), search_from, header_.size());
+        if (header_length == std::string_view::npos)
+        {
+            if (header_.size() > max_header_size)
+                state_ = State::Error;
+            return size;
+        }
+
+        const size_t consumed = size - (header_.size() - header_length);
+        header_.resize(header_length);
+        parse_header();
+        return consumed;
+    }
+
+    void parse_header()
+    {
+        std::string_view header(header_);
+        auto line_end = header.find("\r\n");
+        std::string_view status_line = header.substr(0, line_end);
+
+        // e.g. "HTTP/1.1 200 OK"
+        if ((status_line.size() < 12) || (status_line.substr(0, 5) != "HTTP/"))
+        {
+            state_ = State::Error;
+            return;
+        }
+        keep_alive_ = (status_line.substr(5, 3) != "1.0");
+        status_code_ = std::atoi(std::string(status_line.substr(9, 3)).c_str());
+
+        bool chunked(false), has_length(false);
+        while (line_end != std::string_view::npos)
+        {
+            header.remove_prefix(line_end + 2);
+            line_end = header.find("\r\n");
+            std::string_view line = header.substr(0, line_end);
+            auto colon = line.find(':');
+            if (colon == std::string_view::npos)
+                continue;
+
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+
+            if (iequals(name, "Content-Length"))
+            {
+                remaining_ = std::strtoull(std::string(value).c_str(), nullptr, 10);
+                has_length = true;
+            }
+            else if (iequals(name, "Transfer-Encoding"))
+                chunked = icontains(value, "chunked");
+            else if (iequals(name, "Connection"))
+            {
+                if (icontains(value, "close"))
+                    keep_alive_ = false;
+                else if (icontains(value, "keep-alive"))
+                    keep_alive_ = true;
+            }
+        }
+
+        header_.clear();
+        header_.shrink_to_fit();
+
+        if (((status_code_ >= 100) && (status_code_ < 200)) || (status_code_ == 204) || (status_code_ == 304))
+            state_ = State::Complete;
+        else if (chunked)
+            state_ = State::ChunkSize;
+        else if (has_length)
+            state_ = (remaining_ == 0) ? State::Complete : State::Body;
+        else
+            state_ = State::UntilClose;
+    }
+
+    size_t feed_chunk_size(const char* data, size_t size)
+    {
+        size_t pos = 0;
+        while (pos < size)
+        {
+            char c = data[pos++];
+            if (c == '\n')
+            {
+                if (!chunk_size_digits_)
+                {
+                    state_ = State::Error;
+                    return pos;
+                }
+                chunk_size_digits_ = 0;
+                chunk_extension_ = false;
+                if (remaining_ == 0)
+                    state_ = State::Trailer;
+                else
+                    state_ = State::ChunkData;
+                return pos;
+            }
+            if (chunk_extension_ || (c == '\r'))
+                continue;
+            if ((c == ';') || (c == ' ') || (c == '\t'))
+            {
+                chunk_extension_ = true;
+                continue;
+            }
+
+            int digit = hex_digit(c);
+            if ((digit < 0) || (++chunk_size_digits_ > 16))
+            {
+                state_ = State::Error;
+                return pos;
+            }
+            remaining_ = (remaining_ << 4) | static_cast<size_t>(digit);
+        }
+        return pos;
+    }
+
+    size_t feed_trailer(const char* data, size_t size)
+    {
+        size_t pos = 0;
+        while (pos < size)
+        {
+            char c = data[pos++];
+            if (c == '\n')
+            {
+                if (trailer_line_length_ == 0)
+                {
+                    state_ = State::Complete;
+                    return pos;
+                }
+                trailer_line_length_ = 0;
+            }
+            else if (c != '\r')
+                ++trailer_line_length_;
+        }
+        return pos;
+    }
+
+    static int hex_digit(char c)
+    {
+        if ((c >= '0') && (c <= '9'))
+            return c - '0';
+        if ((c >= 'a') && (c <= 'f'))
+            return c - 'a' + 10;
+        if ((c >= 'A') && (c <= 'F'))
+            return c - 'A' + 10;
+        return -1;
+    }
+
+private:
+    State state_ = State::Header;
+    std::string header_;
+    size_t remaining_ = 0;
+    size_t chunk_size_digits_ = 0;
+    size_t trailer_line_length_ = 0;
+    bool chunk_extension_ = false;
+    bool keep_alive_ = true;
+    int status_code_ = 0;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+// connections the kernel has refused because a listening socket's accept queue was full
+// (network namespace wide, all the listening sockets of the host or container)
+struct ListenOverflows
+{
+    uint64_t overflows = 0; // accept queue full (TcpExt ListenOverflows)
+    uint64_t drops = 0;     // dropped for any reason, overflows included (TcpExt ListenDrops)
+};
+
+// ListenOverflows and ListenDrops of a /proc/net/netstat text ("TcpExt:" names line
+// followed by the values line), nullopt if they are missing
+inline std::optional<ListenOverflows> parse_listen_overflows(std::string_view text)
+{
+    auto split = [](std::string_view line)
+    {
+        std::vector<std::string> words;
+        std::istringstream stream{std::string(line)};
+        for (std::string word; stream >> word;)
+            words.push_back(std::move(word));
+        return words;
+    };
+
+    std::vector<std::string> names;
+    while (!text.empty())
+    {
+        const auto eol = text.find('\n');
+        const std::string_view line = text.substr(0, eol);
+        text = (eol == std::string_view::npos) ? std::string_view() : text.substr(eol + 1);
+
+        if (line.rfind("TcpExt:", 0) != 0)
+            continue;
+        if (names.empty())
+        {
+            names = split(line);
+            continue;
+        }
+
+        const std::vector<std::string> values = split(line);
+        std::optional<uint64_t> overflows, drops;
+        for (size_t i = 1; (i < names.size()) && (i < values.size()); i++)
+        {
+            if (names[i] == "ListenOverflows")
+                overflows = std::strtoull(values[i].c_str(), nullptr, 10);
+            else if (names[i] == "ListenDrops")
+                drops = std::strtoull(values[i].c_str(), nullptr, 10);
+        }
+        if (!overflows || !drops)
+            return std::nullopt;
+        return ListenOverflows{*overflows, *drops};
+    }
+    return std::nullopt;
+}
+
+// current kernel counters, nullopt where they aren't available
+inline std::optional<ListenOverflows> read_listen_overflows()
+{
+#ifdef __linux__
+    std::ifstream file("/proc/net/netstat");
+    std::ostringstream text;
+    text << file.rdbuf();
+    return parse_listen_overflows(text.str());
+#else
+    return std::nullopt;
+#endif
+}
+
+#ifdef __linux__
+// connections waiting in the accept queue of a listening socket
+inline std::optional<uint32_t> accept_queue_length(int listening_socket)
+{
+    tcp_info info{};
+    socklen_t size = sizeof(info);
+    if (getsockopt(listening_socket, IPPROTO_TCP, TCP_INFO, &info, &size) != 0)
+        return std::nullopt;
+    return info.tcpi_unacked; // the accept queue length for a socket in the LISTEN state
+}
+#endif
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "common/stats.h"
+
+// Per-thread freelists of the blocks of objects created and destroyed at a high rate
+// (sessions, exchanges), reused instead of going back to the heap.
+// Tag names the pool and its counters in gl_stats:
+//     struct Tag { static constexpr auto hits = &Stats::...; static constexpr auto misses = &Stats::...; };
+// A pool holds blocks of a single size (that of its first block), a block freed on another
+// thread than the one that allocated it joins the freeing thread's list.
+// Each thread keeps at most capacity() blocks, the others are released to the heap.
+// The hits and misses are counted by each thread in its own free list, they're added
+// to gl_stats when the stats are read (collect()) and when the thread exits.
+template <typename Tag>
+class RecyclingPool
+{
+public:
+    constexpr static size_t default_capacity = 256;
+
+    static void set_capacity(size_t capacity)
+    {
+        capacity_.store(capacity, std::memory_order_relaxed);
+    }
+
+    static size_t capacity()
+    {
+        return capacity_.load(std::memory_order_relaxed);
+    }
+
+    static void* allocate(size_t size)
+    {
+        FreeList& list = free_list_;
+        if (!list.registered)
+            register_list(list);
+
+        if (list.head && (size == list.block_size))
+        {
+            increment(list.hits);
+            Block* block = list.head;
+            list.head = block->next;
+            list.count--;
+            return block;
+        }
+
+        increment(list.misses);
+        return ::operator new(size);
+    }
+
+    static void deallocate(void* p, size_t size)
+    {
+        FreeList& list = free_list_;
+        if (list.block_size == 0)
+            list.block_size = size;
+
+        if (!list.closed && (size == list.block_size) && (size >= sizeof(Block)) && (list.count < capacity()))
+        {
+            if (list.count++ == 0)
+                list_release_.armed = true; // registers the thread's release at exit
+            list.head = new (p) Block{list.head};
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    // adds the hits and misses of the running threads since the previous call to gl_stats
+    static void collect()
+    {
+        std::lock_guard<std::mutex> lock(lists_mutex_);
+        for (FreeList* list : lists_)
+            collect(*list);
+    }
+
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    // trivially destructible: still usable by the blocks freed while the thread exits
+    struct FreeList
+    {
+        Block* head = nullptr;
+        size_t count = 0;
+        size_t block_size = 0;
+        bool closed = false;
+        bool registered = false;
+        // written by the thread only, read by collect()
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        // already in gl_stats, lists_mutex_
+        uint64_t collected_hits = 0;
+        uint64_t collected_misses = 0;
+    };
+
+    // releases the thread's blocks and collects its counters when it exits
+    struct Release
+    {
+        bool armed = false;
+
+        ~Release()
+        {
+            FreeList& list = free_list_;
+            list.closed = true;
+            while (list.head)
+                ::operator delete(std::exchange(list.head, list.head->next));
+            list.count = 0;
+
+            if (list.registered)
+            {
+                std::lock_guard<std::mutex> lock(lists_mutex_);
+                collect(list);
+                lists_.erase(std::find(lists_.begin(), lists_.end(), &list));
+            }
+        }
+    };
+
+    // the thread's own counter: a plain load and store, no locked read-modify-write
+    static void increment(std::atomic<uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void register_list(FreeList& list)
+    {
+        static const bool collector_added = (gl_stats.add_collector(&RecyclingPool::collect), true);
+        (void)collector_added;
+
+        std::lock_guard<std::mutex> lock(lists_mutex_);
+        lists_.push_back(&list);
+        list.registered = true;
+        list_release_.armed = true; // registers the thread's release at exit
+    }
+
+    // expects lists_mutex_ to be held
+    static void collect(FreeList& list)
+    {
+        const uint64_t hits = list.hits.load(std::memory_order_relaxed);
+        const uint64_t misses = list.misses.load(std::memory_order_relaxed);
+        (gl_stats.*Tag::hits).fetch_add(hits - list.collected_hits, std::memory_order_relaxed);
+        (gl_stats.*Tag::misses).fetch_add(misses - list.collected_misses, std::memory_order_relaxed);
+        list.collected_hits = hits;
+        list.collected_misses = misses;
+    }
+
+    static inline thread_local FreeList free_list_;
+    static inline thread_local Release list_release_;
+    static inline std::atomic<size_t> capacity_{default_capacity};
+    static inline std::mutex lists_mutex_;
+    static inline std::vector<FreeList*> lists_; // of the running threads
+};
+
+// std::allocate_shared allocator drawing the object and its control block from a RecyclingPool
+template <typename T, typename Tag>
+class RecyclingAllocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = RecyclingAllocator<U, Tag>;
+    };
+
+    RecyclingAllocator() noexcept = default;
+    template <typename U>
+    RecyclingAllocator(const RecyclingAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned types aren't pooled");
+        return static_cast<T*>(RecyclingPool<Tag>::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        RecyclingPool<Tag>::deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const RecyclingAllocator<U, Tag>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const RecyclingAllocator<U, Tag>&) const noexcept { return false; }
+};
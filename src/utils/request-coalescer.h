@@ -0,0 +1,67 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/buffer-chain.h"
+
+// Single-flight table for identical in-flight requests.
+// The first request of a key leads the flight and fetches the response,
+// the ones arriving meanwhile wait for it and share the same response bytes.
+class RequestCoalescer
+{
+public:
+    // response is null if the leader has failed
+    using Handler = std::function<void(SharedBufferChain response, bool persistent)>;
+
+    // true if the caller leads the flight and has to complete it,
+    // otherwise the handler is called once the leader completes
+    bool join(const std::string& key, Handler handler)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto [it, inserted] = flights_.try_emplace(key);
+        if (!inserted)
+            it->second.push_back(std::move(handler));
+        return inserted;
+    }
+
+    // starts a flight only if there is none for the key (background fetches)
+    bool lead(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flights_.try_emplace(key).second;
+    }
+
+    // ends the flight, the waiters are called outside of the lock
+    void complete(const std::string& key, SharedBufferChain response, bool persistent)
+    {
+        std::vector<Handler> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto it = flights_.find(key);
+            if (it == flights_.end())
+                return;
+            waiters = std::move(it->second);
+            flights_.erase(it);
+        }
+
+        for (auto& waiter : waiters)
+            waiter(response, persistent);
+    }
+
+    size_t in_flight() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flights_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<Handler>> flights_;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/stats.h"
+#include "utils/buffer-chain.h"
+
+// In-memory cache of complete upstream responses.
+// Entries live for the TTL of the longest rule matching the request path
+// (a zero TTL bypasses the cache), the least recently used ones are evicted
+// to stay within the memory budget.
+// An expired entry is still served during its stale window while it is
+// being refreshed, and a frequently hit entry is due for a refresh shortly
+// before it expires, so its clients never wait for the upstream.
+class ResponseCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Policy
+    {
+        std::chrono::milliseconds ttl{0};   // 0: not cached
+        std::chrono::milliseconds stale{0}; // served past the TTL while being refreshed
+    };
+
+    struct Rule
+    {
+        std::string path_prefix;
+        Policy policy;
+    };
+
+    enum class Freshness
+    {
+        Fresh,
+        RefreshDue, // fresh, but expires before the next hits are expected
+        Stale       // past the TTL, within the stale window
+    };
+
+    struct Lookup
+    {
+        SharedBufferChain response; // null if there is no usable entry
+        Freshness freshness = Freshness::Fresh;
+    };
+
+    // a refresh ahead only pays off if the renewed entry is expected to be hit this many times
+    constexpr static uint64_t refresh_ahead_min_hits = 2;
+
+    struct Options
+    {
+        size_t max_size = 64 * 1024 * 1024; // bytes, 0 disables the cache
+        std::vector<Rule> rules = default_rules();
+    };
+
+    static std::vector<Rule> default_rules()
+    {
+        using namespace std::chrono_literals;
+        return {{"/api/v3/exchangeInfo", {60s, 300s}},
+                {"/api/v3/ticker", {250ms}},
+                {"/api/v3/depth", {0ms}}};
+    }
+
+    // "<path prefix>=<ttl>[:<stale window>]", milliseconds, e.g. "/api/v3/klines=1000:5000"
+    static std::optional<Rule> parse_rule(std::string_view text)
+    {
+        const auto pos = text.rfind('=');
+        if ((pos == std::string_view::npos) || (pos == 0) || (text.front() != '/'))
+            return std::nullopt;
+
+        std::string_view ttl = text.substr(pos + 1);
+        std::string_view stale;
+        if (const auto colon = ttl.find(':'); colon != std::string_view::npos)
+        {
+            stale = ttl.substr(colon + 1);
+            ttl = ttl.substr(0, colon);
+            if (stale.empty())
+                return std::nullopt;
+        }
+
+        Rule rule{std::string(text.substr(0, pos)), {}};
+        if (!parse_milliseconds(ttl, rule.policy.ttl) ||
+            (!stale.empty() && !parse_milliseconds(stale, rule.policy.stale)))
+            return std::nullopt;
+        return rule;
+    }
+
+    // a rule for an already known prefix replaces it
+    static void add_rule(std::vector<Rule>& rules, Rule rule)
+    {
+        for (auto& existing : rules)
+            if (existing.path_prefix == rule.path_prefix)
+            {
+                existing.policy = rule.policy;
+                return;
+            }
+        rules.push_back(std::move(rule));
+    }
+
+    ResponseCache() : ResponseCache(Options()) {}
+    explicit ResponseCache(Options options) : options_(std::move(options)) {}
+
+    bool enabled() const { return options_.max_size > 0; }
+
+    Policy policy(std::string_view path) const
+    {
+        const Rule* match = nullptr;
+        for (const auto& rule : options_.rules)
+            if ((path.substr(0, rule.path_prefix.size()) == rule.path_prefix) &&
+                (!match || (rule.path_prefix.size() > match->path_prefix.size())))
+                match = &rule;
+        return match ? match->policy : Policy();
+    }
+
+    Lookup find(const std::string& key, Clock::time_point now = Clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = entries_.find(key);
+        if (it == entries_.end())
+            return {};
+
+        Entry& entry = it->second;
+        if (entry.stale_until <= now)
+        {
+            erase(it);
+            return {};
+        }
+
+        lru_.splice(lru_.begin(), lru_, entry.lru);
+        entry.hits++;
+
+        if (entry.fresh_until <= now)
+            return {entry.response, Freshness::Stale};
+
+        return {entry.response, refresh_due(entry, now) ? Freshness::RefreshDue : Freshness::Fresh};
+    }
+
+    // fetch_time: how long the upstream took to deliver the response
+    void store(const std::string& key, SharedBufferChain response, Policy policy,
+               std::chrono::milliseconds fetch_time = {}, Clock::time_point now = Clock::now())
+    {
+        if (!enabled() || (policy.ttl.count() == 0) || (response->size() > options_.max_size))
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = entries_.find(key);
+        if (it != entries_.end())
+            erase(it);
+
+        while (size_ + response->size() > options_.max_size)
+        {
+            erase(entries_.find(lru_.back()));
+            gl_stats.cache_evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lru_.push_front(key);
+        size_ += response->size();
+        entries_.emplace(key, Entry{std::move(response), now, now + policy.ttl,
+                                    now + policy.ttl + policy.stale, fetch_time, 0, lru_.begin()});
+
+        gl_stats.cache_stores.fetch_add(1, std::memory_order_relaxed);
+        gl_stats.cache_size.store(size_, std::memory_order_relaxed);
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    size_t entries() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+private:
+    struct Entry
+    {
+        SharedBufferChain response;
+        Clock::time_point stored_at;
+        Clock::time_point fresh_until;
+        Clock::time_point stale_until;
+        std::chrono::milliseconds fetch_time;
+        uint64_t hits;
+        std::list<std::string>::iterator lru;
+    };
+
+    static bool parse_milliseconds(std::string_view text, std::chrono::milliseconds& result)
+    {
+        if (text.empty() || (text.front() == '-'))
+            return false;
+
+        const std::string value(text);
+        char* end = nullptr;
+        result = std::chrono::milliseconds(std::strtoull(value.c_str(), &end, 10));
+        return *end == '\0';
+    }
+
+    // the refresh has to start a fetch time plus a mean gap between hits before the expiration,
+    // so the renewed response is there in time and a hit is likely to trigger it
+    static bool refresh_due(const Entry& entry, Clock::time_point now)
+    {
+        if (entry.hits < refresh_ahead_min_hits)
+            return false;
+
+        const auto ttl = entry.fresh_until - entry.stored_at;
+        const auto hit_gap = (now - entry.stored_at) / entry.hits;
+        if (hit_gap * refresh_ahead_min_hits > ttl)
+            return false; // not hot enough
+
+        const auto window = std::min<Clock::duration>(hit_gap + entry.fetch_time, ttl / 2);
+        return entry.fresh_until - now <= window;
+    }
+
+    void erase(std::unordered_map<std::string, Entry>::iterator it)
+    {
+        size_ -= it->second.response->size();
+        lru_.erase(it->second.lru);
+        entries_.erase(it);
+        gl_stats.cache_size.store(size_, std::memory_order_relaxed);
+    }
+
+private:
+    const Options options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_; // most recently used first
+    size_t size_ = 0;
+};
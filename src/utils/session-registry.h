@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/session.h"
+#include "common/stats.h"
+
+// Live client sessions of the server.
+// A session is added once started and removed by its registration
+// when destroyed, so the registry only holds live sessions.
+// Sessions are spread over shards by id: io threads adding and removing
+// concurrently rarely contend for the same lock.
+class SessionRegistry
+{
+    constexpr static size_t shard_count = 16;
+
+public:
+    // removes the session from the registry when destroyed, held by the session
+    class Registration
+    {
+    public:
+        Registration() = default;
+        Registration(SessionRegistry* registry, uint64_t id) : registry_(registry), id_(id) {}
+        Registration(Registration&& other) noexcept
+            : registry_(std::exchange(other.registry_, nullptr)), id_(other.id_) {}
+        Registration& operator=(Registration&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                registry_ = std::exchange(other.registry_, nullptr);
+                id_ = other.id_;
+            }
+            return *this;
+        }
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+        ~Registration() { reset(); }
+
+        void reset()
+        {
+            if (registry_)
+                std::exchange(registry_, nullptr)->remove(id_);
+        }
+
+    private:
+        SessionRegistry* registry_ = nullptr;
+        uint64_t id_ = 0;
+    };
+
+    SessionRegistry() = default;
+    SessionRegistry(const SessionRegistry&) = delete;
+    SessionRegistry& operator=(const SessionRegistry&) = delete;
+
+    Registration add(const std::shared_ptr<Session>& session)
+    {
+        const uint64_t id = session->get_id();
+        Shard& shard = shard_of(id);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!shard.sessions.insert_or_assign(id, session).second)
+                return Registration(this, id); // already counted
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+        gl_stats.client_sessions.fetch_add(1, std::memory_order_relaxed);
+        return Registration(this, id);
+    }
+
+    size_t size() const
+    {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    // calls fn for every live session, outside of the locks
+    // (fn may lead to sessions being removed)
+    template <typename Fn>
+    void for_each(Fn fn)
+    {
+        std::vector<std::shared_ptr<Session>> sessions;
+        sessions.reserve(size());
+        for (auto& shard : shards_)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto& [id, weak] : shard.sessions)
+                if (auto session = weak.lock())
+                    sessions.push_back(std::move(session));
+        }
+
+        for (auto& session : sessions)
+            fn(*session);
+    }
+
+private:
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::weak_ptr<Session>> sessions;
+    };
+
+    Shard& shard_of(uint64_t id)
+    {
+        return shards_[id % shard_count];
+    }
+
+    void remove(uint64_t id)
+    {
+        Shard& shard = shard_of(id);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.sessions.erase(id) == 0)
+                return;
+        }
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        gl_stats.client_sessions.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<Shard, shard_count> shards_;
+    std::atomic<size_t> size_{0};
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Vector of trivially copyable elements, the first N of them kept inline:
+// no allocation until it grows past N, then its elements move to the heap.
+template <typename T, size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "elements are copied as bytes");
+
+public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other)
+    {
+        append(other);
+    }
+
+    SmallVector(SmallVector&& other) noexcept
+    {
+        take(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+        {
+            size_ = 0;
+            append(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if (this != &other)
+            take(other);
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return heap_ ? heap_capacity_ : N; }
+    bool is_inline() const { return !heap_; }
+
+    T* data() { return heap_ ? heap_.get() : inline_.data(); }
+    const T* data() const { return heap_ ? heap_.get() : inline_.data(); }
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+    void push_back(const T& value)
+    {
+        if (size_ == capacity())
+            reserve(2 * capacity());
+        data()[size_++] = value;
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity <= this->capacity())
+            return;
+
+        auto heap = std::make_unique<T[]>(capacity);
+        std::copy_n(data(), size_, heap.get());
+        heap_ = std::move(heap);
+        heap_capacity_ = capacity;
+    }
+
+    // the heap storage, if any, is kept for reuse
+    void clear() { size_ = 0; }
+
+private:
+    void append(const SmallVector& other)
+    {
+        reserve(size_ + other.size_);
+        std::copy_n(other.data(), other.size_, data() + size_);
+        size_ += other.size_;
+    }
+
+    void take(SmallVector& other)
+    {
+        heap_ = std::move(other.heap_);
+        heap_capacity_ = other.heap_capacity_;
+        size_ = other.size_;
+        if (!heap_)
+            std::copy_n(other.inline_.data(), size_, inline_.data());
+
+        other.heap_capacity_ = 0;
+        other.size_ = 0;
+    }
+
+private:
+    std::array<T, N> inline_;
+    std::unique_ptr<T[]> heap_;
+    size_t heap_capacity_ = 0;
+    size_t size_ = 0;
+};
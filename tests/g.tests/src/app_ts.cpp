@@ -95,6 +95,22 @@ class RunMode_TS : protected TestBase,
     };
 };
 
+using RelayModePair = std::pair<std::string, RelayMode>;
+
+class RelayMode_TS : protected TestBase,
+                     public ::testing::TestWithParam<RelayModePair>
+{
+    void SetUp() override
+    {
+        TestBase::SetUp();
+    }
+
+    void TearDown() override
+    {
+        TestBase::TearDown();
+    };
+};
+
 TEST_F(CommandLineTS, EmptyLineTest)
 {
     in_args_ = {""};
@@ -108,6 +124,23 @@ TEST_F(CommandLineTS, EmptyLineTest)
     EXPECT_EQ(out_args_.log_level, spdlog::level::level_enum::info);
     EXPECT_EQ(out_args_.running_mode, ServerRunningMode::Persistent);
     EXPECT_EQ(out_args_.logger_type, default_log_type);
+    EXPECT_EQ(out_args_.upstream_pool.min_size, UpstreamPool::Options().min_size);
+    EXPECT_EQ(out_args_.upstream_pool.max_size, UpstreamPool::Options().max_size);
+    EXPECT_EQ(out_args_.upstream_pool.idle_timeout, UpstreamPool::Options().idle_timeout);
+    EXPECT_EQ(out_args_.session.relay_mode, RelayMode::Streaming);
+    EXPECT_EQ(out_args_.session.keep_alive_timeout, SessionOptions().keep_alive_timeout);
+    EXPECT_TRUE(out_args_.session.coalescing);
+    EXPECT_EQ(out_args_.server.threads, 0u);
+    EXPECT_FALSE(out_args_.server.pin_threads);
+    EXPECT_EQ(out_args_.server.engine, EngineMode::Shared);
+    EXPECT_EQ(out_args_.server.session_engine, SessionEngine::Callback);
+    EXPECT_EQ(out_args_.server.first_byte_timeout, ServerOptions().first_byte_timeout);
+    EXPECT_EQ(out_args_.server.pending_accepts, ServerOptions().pending_accepts);
+    EXPECT_EQ(out_args_.server.session_pool, ServerOptions().session_pool);
+    EXPECT_EQ(out_args_.server.listen_backlog, 0);
+    EXPECT_EQ(out_args_.server.tls.port, 0u);
+    EXPECT_EQ(out_args_.response_cache.max_size, ResponseCache::Options().max_size);
+    EXPECT_EQ(out_args_.response_cache.rules.size(), ResponseCache::default_rules().size());
 
     EXPECT_FALSE(usage_requested);
     EXPECT_FALSE(gl_show_usage_called);
@@ -146,6 +179,250 @@ TEST_F(CommandLineTS, PortArgTest)
     EXPECT_FALSE(gl_show_usage_called);
 }
 
+TEST_F(CommandLineTS, UpstreamPoolArgTest)
+{
+    in_args_ = {"", "--pool-min", "4", "--pool-max", "16", "--pool-idle-timeout", "10", "--dns-ttl", "300",
+                "--connect-stagger", "100"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+
+    EXPECT_EQ(out_args_.port, default_http_port);
+    EXPECT_EQ(out_args_.upstream_pool.min_size, 4u);
+    EXPECT_EQ(out_args_.upstream_pool.max_size, 16u);
+    EXPECT_EQ(out_args_.upstream_pool.idle_timeout, std::chrono::seconds(10));
+    EXPECT_EQ(out_args_.upstream_pool.dns_ttl, std::chrono::seconds(300));
+    EXPECT_EQ(out_args_.upstream_pool.connect_stagger, std::chrono::milliseconds(100));
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, PoolMinAboveMaxArgTest)
+{
+    in_args_ = {"", "--pool-min", "8", "--pool-max", "4"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, NoPoolIdleTimeoutArgTest)
+{
+    in_args_ = {"", "--pool-idle-timeout", "0"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, NoDnsTtlArgTest)
+{
+    in_args_ = {"", "--dns-ttl", "0"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, KeepAliveTimeoutArgTest)
+{
+    in_args_ = {"", "--keep-alive-timeout", "0"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.session.keep_alive_timeout, std::chrono::seconds(0));
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, FirstByteTimeoutArgTest)
+{
+    in_args_ = {"", "--first-byte-timeout", "500"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.first_byte_timeout, std::chrono::milliseconds(500));
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, TlsArgTest)
+{
+    in_args_ = {"", "--tls-port", "8443", "--tls-cert", "server.pem", "--tls-key", "server.key"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.tls.port, 8443u);
+    EXPECT_EQ(out_args_.server.tls.certificate_file, "server.pem");
+    EXPECT_EQ(out_args_.server.tls.private_key_file, "server.key");
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, TlsWithoutCertificateArgTest)
+{
+    in_args_ = {"", "--tls-port", "8443"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, ThreadsArgTest)
+{
+    in_args_ = {"", "--threads", "8", "--pin-threads"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.threads, 8u);
+    EXPECT_TRUE(out_args_.server.pin_threads);
+    EXPECT_EQ(out_args_.server.engine, EngineMode::Shared);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, EngineArgTest)
+{
+    in_args_ = {"", "--engine", "per-core", "--threads", "4"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.engine, EngineMode::PerCore);
+    EXPECT_EQ(out_args_.server.threads, 4u);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, AcceptArgTest)
+{
+    in_args_ = {"", "--pending-accepts", "16", "--listen-backlog", "4096"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.pending_accepts, 16u);
+    EXPECT_EQ(out_args_.server.listen_backlog, 4096);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, SessionPoolArgTest)
+{
+    in_args_ = {"", "--session-pool", "0"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.session_pool, 0u);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, NoPendingAcceptsArgTest)
+{
+    in_args_ = {"", "--pending-accepts", "0"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, SessionEngineArgTest)
+{
+    in_args_ = {"", "--session-engine", "coroutine"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+#ifdef MB_COROUTINES
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.server.session_engine, SessionEngine::Coroutine);
+#else
+    // not available without the C++20 build
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_EQ(out_args_.server.session_engine, SessionEngine::Callback);
+#endif
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, CacheArgTest)
+{
+    in_args_ = {"", "--cache-size", "16", "--cache-rule", "/api/v3/klines=1000,/api/v3/depth=100"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.response_cache.max_size, 16u * 1024 * 1024);
+
+    ResponseCache cache(out_args_.response_cache);
+    EXPECT_EQ(cache.policy("/api/v3/klines").ttl, std::chrono::milliseconds(1000));
+    EXPECT_EQ(cache.policy("/api/v3/depth").ttl, std::chrono::milliseconds(100));
+    EXPECT_EQ(cache.policy("/api/v3/exchangeInfo").ttl, std::chrono::seconds(60));
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
+TEST_F(CommandLineTS, InvalidCacheRuleArgTest)
+{
+    in_args_ = {"", "--cache-rule", "/api/v3/klines"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 1);
+    EXPECT_FALSE(usage_requested);
+}
+
+TEST_F(CommandLineTS, NoCoalescingArgTest)
+{
+    in_args_ = {"", "--no-coalescing"};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_FALSE(out_args_.session.coalescing);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
+
 INSTANTIATE_TEST_SUITE_P(LogLevelArg,
                          LogLevel_TS,
                          ::testing::Values(
@@ -226,3 +503,27 @@ TEST_P(RunMode_TS, RunMode)
     EXPECT_FALSE(usage_requested);
     EXPECT_FALSE(gl_show_usage_called);
 }
+
+INSTANTIATE_TEST_SUITE_P(RelayMode,
+                         RelayMode_TS,
+                         ::testing::Values(
+                             RelayModePair("stream", RelayMode::Streaming),
+                             RelayModePair("buffer", RelayMode::Buffered)));
+
+TEST_P(RelayMode_TS, RelayMode)
+{
+    auto [relay_mode_str, relay_mode] = GetParam();
+    in_args_ = {"", "--relay-mode", relay_mode_str.data()};
+
+    const auto [exit_code, usage_requested] =
+        process_arguments(in_args_.size(), in_args_.data(), out_args_);
+
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(out_args_.port, default_http_port);
+    EXPECT_EQ(out_args_.running_mode, ServerRunningMode::Persistent);
+
+    EXPECT_EQ(out_args_.session.relay_mode, relay_mode);
+
+    EXPECT_FALSE(usage_requested);
+    EXPECT_FALSE(gl_show_usage_called);
+}
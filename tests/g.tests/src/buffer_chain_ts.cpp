@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utils/buffer-chain.h"
+
+TEST(BufferChainTS, PrepareCommitTest)
+{
+    BufferChain chain;
+    EXPECT_TRUE(chain.empty());
+
+    auto space = chain.prepare();
+    EXPECT_EQ(space.size(), BufferChain::block_size);
+
+    std::memcpy(space.data(), "HTTP/1.1", 8);
+    chain.commit(8);
+
+    EXPECT_EQ(chain.size(), 8u);
+    EXPECT_EQ(chain.prepare().size(), BufferChain::block_size - 8);
+    EXPECT_EQ(chain.to_string(), "HTTP/1.1");
+}
+
+TEST(BufferChainTS, BlocksTest)
+{
+    const std::string data(BufferChain::block_size * 2 + 100, 'x');
+
+    BufferChain chain;
+    chain.append(data.data(), data.size());
+
+    EXPECT_EQ(chain.size(), data.size());
+    EXPECT_EQ(chain.to_string(), data);
+
+    auto buffers = chain.buffers();
+    ASSERT_EQ(buffers.size(), 3u);
+    EXPECT_EQ(asio::buffer_size(buffers), data.size());
+    EXPECT_EQ(buffers[2].size(), 100u);
+}
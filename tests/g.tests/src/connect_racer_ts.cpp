@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include "connect-racer.h"
+#include "logs/logger.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    tcp::endpoint endpoint(const char* address, unsigned short port = 443)
+    {
+        return tcp::endpoint(asio::ip::make_address(address), port);
+    }
+
+    // a loopback port nothing listens on, a connect is refused right away
+    unsigned short refused_port(asio::io_context& io)
+    {
+        tcp::acceptor acceptor(io, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+        return acceptor.local_endpoint().port();
+    }
+}
+
+class ConnectRacerTS : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!gl_logger)
+            gl_logger = std::make_shared<spdlog::logger>("g-tests", std::make_shared<spdlog::sinks::null_sink_mt>());
+    }
+
+    // runs a race to the end, returns the number of handler calls
+    size_t race(const std::vector<tcp::endpoint>& endpoints, std::chrono::milliseconds stagger)
+    {
+        size_t calls = 0;
+        auto racer = std::make_shared<ConnectRacer>(io_, endpoints, scores_, stagger,
+                                                    [this, &calls](const asio::error_code& ec, tcp::socket socket)
+                                                    {
+                                                        calls++;
+                                                        ec_ = ec;
+                                                        socket_ = std::make_unique<tcp::socket>(std::move(socket));
+                                                    });
+        racer->start();
+        racer.reset();
+
+        io_.run();
+        io_.restart();
+        return calls;
+    }
+
+    asio::io_context io_;
+    EndpointScores scores_;
+    asio::error_code ec_;
+    std::unique_ptr<tcp::socket> socket_;
+};
+
+TEST_F(ConnectRacerTS, ScoresTest)
+{
+    const auto a = endpoint("10.0.0.1");
+    const auto b = endpoint("10.0.0.2");
+
+    EXPECT_EQ(scores_.score(a), 0us);
+
+    scores_.record_rtt(a, 100us);
+    EXPECT_EQ(scores_.score(a), 100us);
+    // EWMA, alpha = 1/4
+    scores_.record_rtt(a, 200us);
+    EXPECT_EQ(scores_.score(a), 125us);
+    // the same address on another port shares the score
+    EXPECT_EQ(scores_.score(endpoint("10.0.0.1", 80)), 125us);
+
+    // measured as 1 us at least, a measured endpoint isn't taken for an unmeasured one
+    scores_.record_rtt(b, 0us);
+    EXPECT_EQ(scores_.score(b), 1us);
+
+    // the failure penalty is smoothed like an RTT
+    scores_.record_failure(b);
+    EXPECT_EQ(scores_.score(b), (1us * 3 + 1s) / 4);
+    scores_.record_rtt(b, 100us);
+    EXPECT_EQ(scores_.score(b), (((1us * 3 + 1s) / 4) * 3 + 100us) / 4);
+}
+
+TEST_F(ConnectRacerTS, OutpacedTest)
+{
+    const auto winner = endpoint("10.0.0.1");
+    const auto measured = endpoint("10.0.0.2");
+    const auto unmeasured = endpoint("10.0.0.3");
+
+    scores_.record_rtt(winner, 2ms);
+    scores_.record_rtt(measured, 10ms);
+
+    // a short elapsed time doesn't lower the score
+    scores_.record_outpaced(measured, 1ms, scores_.score(winner));
+    EXPECT_EQ(scores_.score(measured), 10ms);
+
+    // ranked after the winner
+    scores_.record_outpaced(unmeasured, 1ms, scores_.score(winner));
+    EXPECT_GT(scores_.score(unmeasured), scores_.score(winner));
+    const std::vector<tcp::endpoint> expected{winner, unmeasured};
+    EXPECT_EQ(scores_.order({unmeasured, winner}), expected);
+
+    scores_.record_outpaced(unmeasured, 50ms, scores_.score(winner));
+    EXPECT_EQ(scores_.score(unmeasured), ((2ms + 1us) * 3 + 50ms) / 4);
+}
+
+TEST_F(ConnectRacerTS, OrderTest)
+{
+    const auto fast = endpoint("10.0.0.1");
+    const auto slow = endpoint("10.0.0.2");
+    const auto failed = endpoint("10.0.0.3");
+    const auto unmeasured = endpoint("10.0.0.4");
+    const auto other_unmeasured = endpoint("::1");
+
+    scores_.record_rtt(fast, 2ms);
+    scores_.record_rtt(slow, 40ms);
+    scores_.record_failure(failed);
+
+    // not yet measured ones first (in the given order), then the fastest
+    const std::vector<tcp::endpoint> expected{unmeasured, other_unmeasured, fast, slow, failed};
+    EXPECT_EQ(scores_.order({failed, unmeasured, slow, fast, other_unmeasured}), expected);
+    EXPECT_TRUE(scores_.order({}).empty());
+}
+
+TEST_F(ConnectRacerTS, FailureFallbackTest)
+{
+    tcp::acceptor acceptor(io_, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+    const auto listening = acceptor.local_endpoint();
+    const auto refused = endpoint("127.0.0.2", refused_port(io_));
+
+    // measured as the fastest, the refused endpoint is tried first; its failure
+    // starts the next attempt without waiting for the stagger delay
+    scores_.record_rtt(refused, 1us);
+    scores_.record_rtt(listening, 100ms);
+
+    const auto started_at = std::chrono::steady_clock::now();
+    EXPECT_EQ(race({listening, refused}, 5s), 1u);
+
+    ASSERT_FALSE(ec_) << ec_.message();
+    ASSERT_TRUE(socket_->is_open());
+    EXPECT_EQ(socket_->remote_endpoint(), listening);
+    EXPECT_LT(std::chrono::steady_clock::now() - started_at, 5s);
+    EXPECT_GT(scores_.score(refused), 100ms);
+}
+
+TEST_F(ConnectRacerTS, OutpacedAttemptTest)
+{
+    tcp::acceptor acceptor(io_, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+    const auto listening = acceptor.local_endpoint();
+
+    // a full accept queue: the connects that follow are never answered
+    tcp::acceptor saturated(io_);
+    saturated.open(tcp::v4());
+    saturated.bind(endpoint("127.0.0.2", 0));
+    saturated.listen(0);
+    tcp::socket queued(io_);
+    queued.connect(saturated.local_endpoint());
+    const auto unanswered = saturated.local_endpoint();
+
+    // not yet measured, the unanswered endpoint is tried first and outpaced by the next attempt
+    scores_.record_rtt(listening, 50ms);
+    EXPECT_EQ(race({listening, unanswered}, 20ms), 1u);
+
+    ASSERT_FALSE(ec_) << ec_.message();
+    EXPECT_EQ(socket_->remote_endpoint(), listening);
+    EXPECT_GT(scores_.score(unanswered), scores_.score(listening));
+    const std::vector<tcp::endpoint> expected{listening, unanswered};
+    EXPECT_EQ(scores_.order({unanswered, listening}), expected);
+}
+
+TEST_F(ConnectRacerTS, AllFailedTest)
+{
+    const unsigned short port = refused_port(io_);
+
+    // the failures and the stagger timer race, a single handler call and no extra attempt
+    for (const auto stagger : {0ms, 1ms})
+    {
+        EXPECT_EQ(race({endpoint("127.0.0.2", port), endpoint("127.0.0.3", port), endpoint("127.0.0.4", port)},
+                       stagger),
+                  1u);
+        EXPECT_EQ(ec_, asio::error::connection_refused);
+        EXPECT_FALSE(socket_->is_open());
+    }
+
+    EXPECT_EQ(race({}, 1ms), 1u);
+    EXPECT_EQ(ec_, asio::error::host_not_found);
+}
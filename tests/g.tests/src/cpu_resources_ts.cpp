@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+
+#include "utils/cpu-resources.h"
+
+TEST(CpuResourcesTS, CgroupCpuMaxTest)
+{
+    EXPECT_FALSE(parse_cgroup_cpu_max("max 100000"));
+    EXPECT_FALSE(parse_cgroup_cpu_max(""));
+    EXPECT_FALSE(parse_cgroup_cpu_max("0 100000"));
+
+    auto cpus = parse_cgroup_cpu_max("200000 100000");
+    ASSERT_TRUE(cpus);
+    EXPECT_DOUBLE_EQ(*cpus, 2.0);
+
+    cpus = parse_cgroup_cpu_max("150000 100000\n");
+    ASSERT_TRUE(cpus);
+    EXPECT_DOUBLE_EQ(*cpus, 1.5);
+}
+
+TEST(CpuResourcesTS, DefaultThreadCountTest)
+{
+    const size_t cpus = allowed_cpus().size();
+
+    EXPECT_GE(cpus, 1u);
+    EXPECT_GE(default_thread_count(), 1u);
+    EXPECT_LE(default_thread_count(), cpus);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <asio.hpp>
+#include <vector>
+
+#include "utils/handler-memory.h"
+
+TEST(HandlerMemoryTS, BlocksTest)
+{
+    HandlerMemory memory;
+    const uint64_t fallbacks = gl_stats.handler_memory_fallbacks.load();
+
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < HandlerMemory::block_count; i++)
+        blocks.push_back(memory.allocate(HandlerMemory::block_size));
+    EXPECT_EQ(gl_stats.handler_memory_fallbacks.load(), fallbacks);
+
+    // all the blocks taken: the heap
+    void* extra = memory.allocate(64);
+    EXPECT_EQ(gl_stats.handler_memory_fallbacks.load() - fallbacks, 1u);
+
+    // a returned block is reused
+    memory.deallocate(blocks[2]);
+    EXPECT_EQ(memory.allocate(64), blocks[2]);
+
+    // too large for a block
+    void* large = memory.allocate(HandlerMemory::block_size + 1);
+    EXPECT_EQ(gl_stats.handler_memory_fallbacks.load() - fallbacks, 2u);
+
+    memory.deallocate(large);
+    memory.deallocate(extra);
+    for (void* block : blocks)
+        memory.deallocate(block);
+}
+
+TEST(HandlerMemoryTS, HandlerTest)
+{
+    asio::io_context io;
+    HandlerMemory memory;
+    const uint64_t fallbacks = gl_stats.handler_memory_fallbacks.load();
+
+    int calls = 0;
+    for (int i = 0; i < 16; i++)
+        asio::post(bind_with_memory(io.get_executor(), memory, [&calls]()
+                                    { calls++; }));
+    io.run();
+
+    EXPECT_EQ(calls, 16);
+    // more handlers pending than blocks
+    EXPECT_EQ(gl_stats.handler_memory_fallbacks.load() - fallbacks, 16u - HandlerMemory::block_count);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/header-scanner.h"
+#include "utils/http-request-parser.h"
+
+namespace
+{
+    template <ScanIsa isa>
+    std::vector<size_t> delimiters(const std::string& data, size_t from)
+    {
+        std::vector<size_t> found;
+        const size_t end = scan_delimiters<isa, '\n', ':'>(data.data(), from, data.size(),
+                                                           [&](size_t pos)
+                                                           {
+                                                               found.push_back(pos);
+                                                               return true;
+                                                           });
+        EXPECT_EQ(end, data.size());
+        return found;
+    }
+
+    // the positions found by each instruction set of the build
+    std::vector<std::vector<size_t>> all_delimiters(const std::string& data, size_t from)
+    {
+        std::vector<std::vector<size_t>> results{delimiters<ScanIsa::Scalar>(data, from)};
+#ifdef MB_SCAN_SSE2
+        results.push_back(delimiters<ScanIsa::Sse2>(data, from));
+#endif
+#ifdef __AVX2__
+        results.push_back(delimiters<ScanIsa::Avx2>(data, from));
+#endif
+        return results;
+    }
+}
+
+TEST(HeaderScannerTS, DelimitersTest)
+{
+    std::mt19937 random(7);
+    const std::string alphabet = "ab:\n\r ";
+
+    for (size_t size : {0u, 1u, 15u, 16u, 17u, 31u, 32u, 33u, 100u, 1000u})
+    {
+        std::string data(size, 'a');
+        for (auto& c : data)
+            c = alphabet[random() % alphabet.size()];
+
+        for (size_t from : {0u, 1u, 5u, 16u})
+        {
+            if (from > size)
+                continue;
+
+            std::vector<size_t> expected;
+            for (size_t i = from; i < size; i++)
+                if ((data[i] == '\n') || (data[i] == ':'))
+                    expected.push_back(i);
+
+            for (const auto& found : all_delimiters(data, from))
+                EXPECT_EQ(found, expected) << "size " << size << ", from " << from;
+        }
+    }
+}
+
+TEST(HeaderScannerTS, StopTest)
+{
+    const std::string data = std::string(40, 'a') + ":b\n" + std::string(40, 'c') + "\n";
+
+    size_t calls = 0;
+    const size_t end = scan_delimiters<native_scan_isa, '\n'>(data.data(), 0, data.size(),
+                                                              [&](size_t)
+                                                              {
+                                                                  calls++;
+                                                                  return false;
+                                                              });
+    EXPECT_EQ(calls, 1u);
+    EXPECT_EQ(end, 43u);
+}
+
+TEST(HeaderScannerTS, HeaderEndTest)
+{
+    const std::string head = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n";
+    const std::string response = head + "{}";
+
+    EXPECT_EQ(find_header_end(response.data(), 0, response.size()), head.size());
+    // the terminator straddling the previous search
+    EXPECT_EQ(find_header_end(response.data(), head.size() - 3, response.size()), head.size());
+    EXPECT_EQ(find_header_end(response.data(), 0, head.size() - 1), std::string_view::npos);
+    // bare line feeds don't end a response head
+    EXPECT_EQ(find_header_end("HTTP/1.1 200 OK\n\n\r\n", 0, 19), std::string_view::npos);
+    EXPECT_EQ(find_header_end<ScanIsa::Scalar>(response.data(), 0, response.size()), head.size());
+}
+
+TEST(HeaderScannerTS, ParserIsaTest)
+{
+    const std::string head = "GET /api/v3/klines?symbol=ETHUSDT&interval=1m HTTP/1.1\r\n"
+                             "Host: localhost:8080\r\n"
+                             "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36\r\n"
+                             "Origin: http://localhost:3000\r\n"
+                             "\r\n";
+
+    HttpRequestParser scalar;
+    ASSERT_EQ(scalar.parse<ScanIsa::Scalar>(head), HttpRequestParser::Status::Complete);
+
+    HttpRequestParser native;
+    ASSERT_EQ(native.parse(head), HttpRequestParser::Status::Complete);
+
+    EXPECT_EQ(native.size(), scalar.size());
+    ASSERT_EQ(native.header_count(), scalar.header_count());
+    for (size_t i = 0; i < native.header_count(); i++)
+    {
+        EXPECT_EQ(native.header_name(i), scalar.header_name(i));
+        EXPECT_EQ(native.header_value(i), scalar.header_value(i));
+    }
+    EXPECT_EQ(native.find_header("origin"), "http://localhost:3000");
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "utils/http-headers.h"
+
+TEST(HttpHeadersTS, HeaderIdTest)
+{
+    for (size_t i = 0; i < well_known_header_count; i++)
+    {
+        const auto id = static_cast<HeaderId>(i);
+        std::string name(header_name(id));
+        EXPECT_EQ(header_id(name), id) << name;
+
+        for (auto& c : name)
+            c = ascii_lower(c);
+        EXPECT_EQ(header_id(name), id) << name;
+    }
+    EXPECT_EQ(header_id("HOST"), HeaderId::Host);
+    EXPECT_EQ(header_id("x-mbx-apikey"), HeaderId::XMbxApiKey);
+    EXPECT_EQ(header_id("user-AGENT"), HeaderId::UserAgent);
+
+    // same length and first letter as well-known names
+    for (const char* name : {"Hose", "hos", "User-Agenx", "user_agent", "Content-Lengtx", "X-MBX-APIKEZ", "Accept",
+                             "Origin", ""})
+        EXPECT_EQ(header_id(name), HeaderId::Other) << name;
+
+    // only letters are compared case-insensitively
+    EXPECT_EQ(header_id("User\rAgent"), HeaderId::Other);
+    EXPECT_EQ(header_id(std::string("Conne\x03tion")), HeaderId::Other);
+}
+
+TEST(HttpHeadersTS, SetFindTest)
+{
+    HttpHeaders headers;
+    headers.set("host", "localhost:8080");
+    headers.set("Accept", "*/*");
+    headers.set(HeaderId::Connection, "keep-alive");
+
+    ASSERT_EQ(headers.size(), 3u);
+    EXPECT_EQ(headers.name(0), "host");
+    EXPECT_EQ(headers.id(0), HeaderId::Host);
+    EXPECT_EQ(headers.id(1), HeaderId::Other);
+    EXPECT_EQ(headers.name(2), "Connection");
+
+    EXPECT_EQ(headers.find(HeaderId::Host), "localhost:8080");
+    EXPECT_EQ(headers.find("HOST"), "localhost:8080");
+    EXPECT_EQ(headers.find("accept"), "*/*");
+    EXPECT_FALSE(headers.find(HeaderId::UserAgent));
+    EXPECT_FALSE(headers.find("Origin"));
+
+    // replaced in place, the order of the fields is kept
+    headers.set("CONNECTION", "close");
+    headers.set("ACCEPT", "application/json");
+    ASSERT_EQ(headers.size(), 3u);
+    EXPECT_EQ(headers.value(2), "close");
+    EXPECT_EQ(headers.find("Accept"), "application/json");
+
+    headers.clear();
+    EXPECT_TRUE(headers.empty());
+    EXPECT_FALSE(headers.find(HeaderId::Host));
+}
+
+TEST(HttpHeadersTS, GrowCopyTest)
+{
+    HttpHeaders headers;
+    const size_t count = HttpHeaders::inline_fields * 2 + 1;
+    for (size_t i = 0; i < count; i++)
+        headers.set("X-Field-" + std::to_string(i), std::to_string(i));
+    headers.set(HeaderId::UserAgent, "curl/8.5.0");
+
+    ASSERT_EQ(headers.size(), count + 1);
+    EXPECT_EQ(headers.find("x-field-20"), "20");
+
+    HttpHeaders copy = headers;
+    HttpHeaders moved = std::move(headers);
+    for (const HttpHeaders* h : {&copy, &moved})
+    {
+        ASSERT_EQ(h->size(), count + 1);
+        EXPECT_EQ(h->name(count - 1), "X-Field-" + std::to_string(count - 1));
+        EXPECT_EQ(h->find(HeaderId::UserAgent), "curl/8.5.0");
+    }
+
+    HttpHeaders small;
+    small.set(HeaderId::Host, "localhost");
+    copy = small;
+    ASSERT_EQ(copy.size(), 1u);
+    EXPECT_EQ(copy.find("host"), "localhost");
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utils/http-helper.h"
+#include "utils/http-request-parser.h"
+
+TEST(HttpHelperTS, FindHeaderTest)
+{
+    HttpRequest request = parse_request("GET /api/v3/time HTTP/1.1\r\n"
+                                        "host: localhost:8080\r\n"
+                                        "User-Agent: curl/8.5.0\r\n"
+                                        "\r\n");
+
+    ASSERT_TRUE(find_header(request, "Host"));
+    EXPECT_EQ(*find_header(request, "Host"), "localhost:8080");
+    ASSERT_TRUE(find_header(request, "user-agent"));
+    EXPECT_EQ(*find_header(request, "user-agent"), "curl/8.5.0");
+    EXPECT_FALSE(find_header(request, "Connection"));
+}
+
+TEST(HttpHelperTS, KeepAliveTest)
+{
+    EXPECT_TRUE(is_keep_alive(parse_request("GET / HTTP/1.1\r\n\r\n")));
+    EXPECT_TRUE(is_keep_alive(parse_request("GET / HTTP/1.1\r\nConnection: keep-alive\r\n\r\n")));
+    EXPECT_FALSE(is_keep_alive(parse_request("GET / HTTP/1.1\r\nconnection: Close\r\n\r\n")));
+    EXPECT_FALSE(is_keep_alive(parse_request("GET / HTTP/1.0\r\n\r\n")));
+    EXPECT_TRUE(is_keep_alive(parse_request("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n")));
+}
+
+TEST(HttpHelperTS, NextRequestTest)
+{
+    EXPECT_TRUE(allows_next_request(parse_request("GET / HTTP/1.1\r\n\r\n")));
+    EXPECT_TRUE(allows_next_request(parse_request("GET / HTTP/1.1\r\nContent-Length: 0\r\n\r\n")));
+    EXPECT_TRUE(allows_next_request(parse_request("DELETE /api/v3/order HTTP/1.1\r\n\r\n")));
+
+    // the body bytes are never taken for the next request
+    EXPECT_TRUE(has_body(parse_request("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nbody")));
+    EXPECT_FALSE(allows_next_request(parse_request("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nbody")));
+    EXPECT_FALSE(allows_next_request(parse_request("GET / HTTP/1.1\r\ncontent-length: 010\r\n\r\n")));
+    EXPECT_FALSE(has_body(parse_request("POST / HTTP/1.1\r\nContent-Length: 00\r\n\r\n")));
+
+    // answered with the body of a GET
+    EXPECT_FALSE(allows_next_request(parse_request("HEAD / HTTP/1.1\r\n\r\n")));
+}
+
+TEST(HttpHelperTS, NormalizeTargetTest)
+{
+    EXPECT_EQ(normalize_target("/api/v3/time"), "/api/v3/time");
+    EXPECT_EQ(normalize_target("/api/v3/depth?symbol=BTCUSDT&limit=5"),
+              "/api/v3/depth?limit=5&symbol=BTCUSDT");
+    EXPECT_EQ(normalize_target("/api/v3/depth?limit=5&symbol=BTCUSDT"),
+              "/api/v3/depth?limit=5&symbol=BTCUSDT");
+    EXPECT_EQ(normalize_target("/api/v3/ticker/price?&symbol=ETHUSDT&"), "/api/v3/ticker/price?symbol=ETHUSDT");
+    EXPECT_EQ(normalize_target("/api/v3/ping?"), "/api/v3/ping");
+
+    EXPECT_EQ(target_path("/api/v3/depth?symbol=BTCUSDT"), "/api/v3/depth");
+    EXPECT_EQ(target_path("/api/v3/time"), "/api/v3/time");
+}
+
+TEST(HttpHelperTS, UpstreamRequestTest)
+{
+    const auto request = parse_request("GET /api/v3/time HTTP/1.1\r\nHost: localhost\r\nUser-Agent: curl/8.5.0\r\n\r\n");
+    EXPECT_EQ(format_upstream_request(request, "api.binance.com"),
+              "GET /api/v3/time HTTP/1.1\r\n"
+              "Host: api.binance.com\r\n"
+              "User-Agent: curl/8.5.0\r\n"
+              "Accept: */*\r\n"
+              "Connection: keep-alive\r\n"
+              "\r\n");
+
+    // header names are case-insensitive
+    const auto lower_case = parse_request("GET /api/v3/time HTTP/1.1\r\nuser-agent: python-requests/2.32\r\n\r\n");
+    EXPECT_NE(format_upstream_request(lower_case, "api.binance.com").find("User-Agent: python-requests/2.32\r\n"),
+              std::string::npos);
+
+    const auto anonymous = parse_request("GET /api/v3/ping HTTP/1.1\r\n\r\n");
+    EXPECT_NE(format_upstream_request(anonymous, "api.binance.com").find("User-Agent: market-bridge/1.0.0\r\n"),
+              std::string::npos);
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utils/http-request-parser.h"
+
+class HttpRequestParserTS : public ::testing::Test
+{
+protected:
+    // receives the request in pieces of the given size, each piece appended to a new
+    // buffer (the received bytes move between the calls like in a growing streambuf)
+    HttpRequestParser::Status receive(const std::string& request, size_t piece_size)
+    {
+        auto status = HttpRequestParser::Status::Incomplete;
+        for (size_t pos = 0; (pos < request.size()) && (status == HttpRequestParser::Status::Incomplete);
+             pos += piece_size)
+        {
+            std::string buffer;
+            buffer.reserve(received_.capacity() + 1);
+            buffer = received_ + request.substr(pos, piece_size);
+            received_ = std::move(buffer);
+
+            status = parser_.parse(received_);
+        }
+        return status;
+    }
+
+    HttpRequestParser parser_;
+    std::string received_;
+};
+
+TEST_F(HttpRequestParserTS, CompleteTest)
+{
+    const std::string head = "GET /api/v3/depth?symbol=BTCUSDT&limit=5 HTTP/1.1\r\n"
+                             "Host: localhost:8080\r\n"
+                             "User-Agent:curl/8.5.0\r\n"
+                             "X-MBX-APIKEY:  key \t\r\n"
+                             "Accept: */*\r\n"
+                             "\r\n";
+
+    for (size_t piece_size : {1u, 2u, 7u, 4096u})
+    {
+        parser_.reset();
+        received_.clear();
+        ASSERT_EQ(receive(head + "GET /next", piece_size), HttpRequestParser::Status::Complete);
+
+        EXPECT_EQ(parser_.size(), head.size());
+        EXPECT_EQ(parser_.method(), "GET");
+        EXPECT_EQ(parser_.target(), "/api/v3/depth?symbol=BTCUSDT&limit=5");
+        EXPECT_EQ(parser_.version(), "HTTP/1.1");
+        ASSERT_EQ(parser_.header_count(), 4u);
+        EXPECT_EQ(parser_.header_name(0), "Host");
+        EXPECT_EQ(parser_.header_value(0), "localhost:8080");
+        EXPECT_EQ(parser_.header_id(0), HeaderId::Host);
+        EXPECT_EQ(parser_.header_id(3), HeaderId::Other);
+        EXPECT_EQ(parser_.find_header(HeaderId::XMbxApiKey), "key");
+        EXPECT_EQ(parser_.find_header("user-agent"), "curl/8.5.0");
+        EXPECT_EQ(parser_.find_header("x-mbx-apikey"), "key");
+        EXPECT_TRUE(parser_.find_header("Connection").empty());
+
+        // views into the received bytes, nothing copied
+        EXPECT_GE(parser_.target().data(), received_.data());
+        EXPECT_LT(parser_.target().data(), received_.data() + received_.size());
+    }
+}
+
+TEST_F(HttpRequestParserTS, ProgressTest)
+{
+    EXPECT_EQ(parser_.parse("GET / HTTP/1.1\r\nHo"), HttpRequestParser::Status::Incomplete);
+    EXPECT_EQ(parser_.parsed(), 18u);
+    EXPECT_EQ(parser_.method(), "GET");
+    EXPECT_EQ(parser_.header_count(), 0u);
+
+    EXPECT_EQ(parser_.parse("GET / HTTP/1.1\r\nHost: a\r\n\r"), HttpRequestParser::Status::Incomplete);
+    EXPECT_EQ(parser_.header_count(), 1u);
+
+    EXPECT_EQ(parser_.parse("GET / HTTP/1.1\r\nHost: a\r\n\r\n"), HttpRequestParser::Status::Complete);
+    EXPECT_EQ(parser_.size(), 27u);
+}
+
+TEST_F(HttpRequestParserTS, LenientLineBreaksTest)
+{
+    // empty lines preceding the request line, bare LF line endings
+    EXPECT_EQ(parser_.parse("\r\n\nGET / HTTP/1.0\nConnection: keep-alive\n\n"), HttpRequestParser::Status::Complete);
+    EXPECT_EQ(parser_.target(), "/");
+    EXPECT_EQ(parser_.find_header("Connection"), "keep-alive");
+    EXPECT_EQ(parser_.size(), 42u);
+}
+
+TEST_F(HttpRequestParserTS, MalformedTest)
+{
+    for (const char* request : {"GET /\r\n\r\n", "GET  / HTTP/1.1\r\n\r\n", "GET / HTTP/1.1 x\r\n\r\n",
+                                " GET / HTTP/1.1\r\n\r\n", "GET / HTTP/1.1\r\nHost\r\n\r\n",
+                                "GET / HTTP/1.1\r\nHost : a\r\n\r\n", "GET / HTTP/1.1\r\n: a\r\n\r\n"})
+    {
+        parser_.reset();
+        EXPECT_EQ(parser_.parse(request), HttpRequestParser::Status::Error) << request;
+    }
+}
+
+TEST_F(HttpRequestParserTS, BodyFramingTest)
+{
+    EXPECT_EQ(parser_.parse("GET / HTTP/1.1\r\n\r\n"), HttpRequestParser::Status::Complete);
+    EXPECT_EQ(parser_.content_length(), 0u);
+
+    parser_.reset();
+    EXPECT_EQ(parser_.parse("POST /api/v3/order HTTP/1.1\r\ncontent-length: 12\r\n\r\nsymbol=ETH&"),
+              HttpRequestParser::Status::Complete);
+    EXPECT_EQ(parser_.content_length(), 12u);
+    EXPECT_EQ(parser_.find_header(HeaderId::ContentLength), "12");
+
+    parser_.reset();
+    EXPECT_EQ(parser_.parse("GET / HTTP/1.1\r\nContent-Length: 0\r\n\r\n"), HttpRequestParser::Status::Complete);
+    EXPECT_EQ(parser_.content_length(), 0u);
+
+    // the body couldn't be told apart from the next request
+    for (const char* request : {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+                                "POST / HTTP/1.1\r\ntransfer-encoding: identity\r\nContent-Length: 3\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 5\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: 3, 3\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: +3\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length:\r\n\r\n",
+                                "POST / HTTP/1.1\r\nContent-Length: 18446744073709551617\r\n\r\n"})
+    {
+        parser_.reset();
+        EXPECT_EQ(parser_.parse(request), HttpRequestParser::Status::Error) << request;
+    }
+}
+
+TEST_F(HttpRequestParserTS, LimitsTest)
+{
+    std::string request = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= HttpRequestParser::max_headers; i++)
+        request += "X-Header: value\r\n";
+    EXPECT_EQ(parser_.parse(request + "\r\n"), HttpRequestParser::Status::Error);
+
+    parser_.reset();
+    const std::string line = "GET /" + std::string(HttpRequestParser::max_header_size, 'a');
+    EXPECT_EQ(parser_.parse(line), HttpRequestParser::Status::Error);
+}
+
+TEST_F(HttpRequestParserTS, MakeRequestTest)
+{
+    const std::string raw = "GET /api/v3/time HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(parser_.parse(raw), HttpRequestParser::Status::Complete);
+
+    const HttpRequest request = make_request(parser_);
+    EXPECT_EQ(request.method, "GET");
+    EXPECT_EQ(request.target, "/api/v3/time");
+    EXPECT_EQ(request.version, "HTTP/1.1");
+    ASSERT_TRUE(find_header(request, "host"));
+    EXPECT_EQ(*find_header(request, "host"), "localhost");
+
+    EXPECT_EQ(parse_request(raw + "body").body, "body");
+    EXPECT_TRUE(parse_request("GET / HTTP/1.1\r\n").method.empty());
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utils/http-response-framer.h"
+
+class HttpResponseFramerTS : public ::testing::Test
+{
+protected:
+    // feeds the response in pieces of the given size, returns consumed bytes
+    size_t feed(const std::string& response, size_t piece_size)
+    {
+        size_t consumed(0);
+        for (size_t pos = 0; (pos < response.size()) && !framer_.complete() && !framer_.failed(); pos += piece_size)
+        {
+            const auto piece = response.substr(pos, piece_size);
+            consumed += framer_.feed(piece.data(), piece.size());
+        }
+        return consumed;
+    }
+
+    HttpResponseFramer framer_;
+};
+
+TEST_F(HttpResponseFramerTS, ContentLengthTest)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Type: application/json;charset=UTF-8\r\n"
+                                 "Content-Length: 17\r\n"
+                                 "\r\n"
+                                 "{\"serverTime\":10}";
+
+    for (size_t piece_size : {1u, 3u, 7u, 4096u})
+    {
+        framer_.reset();
+        EXPECT_EQ(feed(response, piece_size), response.size());
+        EXPECT_TRUE(framer_.complete());
+        EXPECT_TRUE(framer_.keep_alive());
+        EXPECT_EQ(framer_.status_code(), 200);
+    }
+}
+
+TEST_F(HttpResponseFramerTS, ChunkedTest)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\n"
+                                 "transfer-encoding: chunked\r\n"
+                                 "\r\n"
+                                 "4\r\n{\"a\"\r\n"
+                                 "a;ext=1\r\n:123456789\r\n"
+                                 "1\r\n}\r\n"
+                                 "0\r\n"
+                                 "\r\n";
+
+    for (size_t piece_size : {1u, 2u, 5u, 4096u})
+    {
+        framer_.reset();
+        EXPECT_EQ(feed(response, piece_size), response.size());
+        EXPECT_TRUE(framer_.complete());
+        EXPECT_TRUE(framer_.keep_alive());
+    }
+}
+
+TEST_F(HttpResponseFramerTS, TrailingBytesTest)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n{}";
+    const std::string input = response + "HTTP/1.1";
+
+    EXPECT_EQ(framer_.feed(input.data(), input.size()), response.size());
+    EXPECT_TRUE(framer_.complete());
+}
+
+TEST_F(HttpResponseFramerTS, ConnectionCloseTest)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\n{}";
+
+    EXPECT_EQ(feed(response, 4096), response.size());
+    EXPECT_TRUE(framer_.complete());
+    EXPECT_FALSE(framer_.keep_alive());
+}
+
+TEST_F(HttpResponseFramerTS, UntilCloseTest)
+{
+    const std::string response = "HTTP/1.0 200 OK\r\n\r\n{}";
+
+    EXPECT_EQ(feed(response, 4096), response.size());
+    EXPECT_FALSE(framer_.complete());
+    EXPECT_TRUE(framer_.reads_until_close());
+    EXPECT_FALSE(framer_.keep_alive());
+}
+
+TEST_F(HttpResponseFramerTS, NoContentTest)
+{
+    const std::string response = "HTTP/1.1 204 No Content\r\n\r\n";
+
+    EXPECT_EQ(feed(response, 4096), response.size());
+    EXPECT_TRUE(framer_.complete());
+    EXPECT_EQ(framer_.status_code(), 204);
+}
+
+TEST_F(HttpResponseFramerTS, MalformedTest)
+{
+    const std::string response = "garbage\r\n\r\n";
+    feed(response, 4096);
+    EXPECT_TRUE(framer_.failed());
+
+    framer_.reset();
+    const std::string bad_chunk = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+    feed(bad_chunk, 4096);
+    EXPECT_TRUE(framer_.failed());
+}
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include "utils/listen-queue.h"
+
+TEST(ListenQueueTS, ParseNetstatTest)
+{
+    const auto counters = parse_listen_overflows(
+        "TcpExt: SyncookiesSent EmbryonicRsts ListenOverflows ListenDrops TCPHPHits\n"
+        "TcpExt: 0 2 17 21 5031\n"
+        "IpExt: InNoRoutes InTruncatedPkts\n"
+        "IpExt: 0 0\n");
+    ASSERT_TRUE(counters);
+    EXPECT_EQ(counters->overflows, 17u);
+    EXPECT_EQ(counters->drops, 21u);
+
+    EXPECT_FALSE(parse_listen_overflows(""));
+    EXPECT_FALSE(parse_listen_overflows("TcpExt: SyncookiesSent ListenOverflows\nTcpExt: 0 3\n"));
+    EXPECT_FALSE(parse_listen_overflows("IpExt: InNoRoutes\nIpExt: 0\n"));
+}
+
+TEST(ListenQueueTS, ReadTest)
+{
+#ifdef __linux__
+    EXPECT_TRUE(read_listen_overflows());
+#else
+    EXPECT_FALSE(read_listen_overflows());
+#endif
+}
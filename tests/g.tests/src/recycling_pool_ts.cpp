@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "utils/recycling-pool.h"
+
+namespace
+{
+    // counters borrowed from gl_stats, the test checks their increments only
+    struct TestBlocks
+    {
+        static constexpr auto hits = &Stats::outgoing_pool_hits;
+        static constexpr auto misses = &Stats::outgoing_pool_misses;
+    };
+
+    struct Object : std::enable_shared_from_this<Object>
+    {
+        explicit Object(int value) : value(value) {}
+
+        std::array<char, 1024> data{};
+        int value;
+    };
+
+    std::shared_ptr<Object> make_object(int value)
+    {
+        return std::allocate_shared<Object>(RecyclingAllocator<Object, TestBlocks>(), value);
+    }
+
+    // the counts of the running threads added to gl_stats
+    uint64_t hits()
+    {
+        RecyclingPool<TestBlocks>::collect();
+        return gl_stats.outgoing_pool_hits.load();
+    }
+
+    uint64_t misses()
+    {
+        RecyclingPool<TestBlocks>::collect();
+        return gl_stats.outgoing_pool_misses.load();
+    }
+}
+
+TEST(RecyclingPoolTS, ReuseTest)
+{
+    const uint64_t hits_before = hits();
+    const uint64_t misses_before = misses();
+
+    void* first = nullptr;
+    {
+        auto object = make_object(1);
+        first = object.get();
+        EXPECT_EQ(object->shared_from_this(), object);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        auto object = make_object(i);
+        EXPECT_EQ(object->value, i);
+        EXPECT_EQ(object.get(), first); // the same block, recycled
+    }
+
+    EXPECT_EQ(misses() - misses_before, 1u);
+    EXPECT_EQ(hits() - hits_before, 8u);
+
+    // counted by the thread, in gl_stats once collected
+    const uint64_t collected = gl_stats.outgoing_pool_hits.load();
+    make_object(0).reset();
+    EXPECT_EQ(gl_stats.outgoing_pool_hits.load(), collected);
+    EXPECT_EQ(hits(), collected + 1);
+}
+
+TEST(RecyclingPoolTS, CapacityTest)
+{
+    RecyclingPool<TestBlocks>::set_capacity(2);
+
+    // a thread of its own: an empty free list
+    std::thread([]()
+                {
+                    std::vector<std::shared_ptr<Object>> objects;
+                    for (int i = 0; i < 4; i++)
+                        objects.push_back(make_object(i));
+                    objects.clear(); // two blocks kept, two released
+
+                    const uint64_t hits_before = hits();
+                    const uint64_t misses_before = misses();
+                    for (int i = 0; i < 4; i++)
+                        objects.push_back(make_object(i));
+
+                    EXPECT_EQ(hits() - hits_before, 2u);
+                    EXPECT_EQ(misses() - misses_before, 2u);
+                })
+        .join();
+
+    RecyclingPool<TestBlocks>::set_capacity(0);
+    std::thread([]()
+                {
+                    make_object(0).reset();
+
+                    const uint64_t hits_before = hits();
+                    make_object(1).reset();
+                    EXPECT_EQ(hits(), hits_before);
+                })
+        .join();
+
+    RecyclingPool<TestBlocks>::set_capacity(RecyclingPool<TestBlocks>::default_capacity);
+}
+
+TEST(RecyclingPoolTS, ThreadExitTest)
+{
+    const uint64_t hits_before = hits();
+    const uint64_t misses_before = misses();
+
+    // the counts of an exited thread are added to gl_stats without a collect()
+    std::thread([]()
+                {
+                    for (int i = 0; i < 3; i++)
+                        make_object(i).reset();
+                })
+        .join();
+
+    EXPECT_EQ(gl_stats.outgoing_pool_misses.load() - misses_before, 1u);
+    EXPECT_EQ(gl_stats.outgoing_pool_hits.load() - hits_before, 2u);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/request-coalescer.h"
+
+TEST(RequestCoalescerTS, SharedResponseTest)
+{
+    RequestCoalescer coalescer;
+    std::vector<SharedBufferChain> received;
+
+    auto handler = [&received](SharedBufferChain response, bool persistent)
+    {
+        EXPECT_TRUE(persistent);
+        received.push_back(response);
+    };
+
+    EXPECT_TRUE(coalescer.join("GET /api/v3/time", handler));
+    EXPECT_FALSE(coalescer.join("GET /api/v3/time", handler));
+    EXPECT_FALSE(coalescer.join("GET /api/v3/time", handler));
+    EXPECT_TRUE(coalescer.join("GET /api/v3/ping", handler));
+    EXPECT_EQ(coalescer.in_flight(), 2u);
+
+    auto response = std::make_shared<BufferChain>();
+    response->append("HTTP/1.1 200 OK\r\n\r\n", 19);
+    coalescer.complete("GET /api/v3/time", response, true);
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0].get(), response.get());
+    EXPECT_EQ(received[1].get(), response.get());
+    EXPECT_EQ(coalescer.in_flight(), 1u);
+
+    // a completed flight is not joined anymore
+    EXPECT_TRUE(coalescer.join("GET /api/v3/time", handler));
+}
+
+TEST(RequestCoalescerTS, FailedLeaderTest)
+{
+    RequestCoalescer coalescer;
+    bool called(false);
+
+    EXPECT_TRUE(coalescer.join("GET /api/v3/depth?symbol=BTCUSDT", nullptr));
+    EXPECT_FALSE(coalescer.join("GET /api/v3/depth?symbol=BTCUSDT",
+                                [&called](SharedBufferChain response, bool)
+                                {
+                                    called = true;
+                                    EXPECT_EQ(response, nullptr);
+                                }));
+
+    coalescer.complete("GET /api/v3/depth?symbol=BTCUSDT", nullptr, false);
+    EXPECT_TRUE(called);
+    EXPECT_EQ(coalescer.in_flight(), 0u);
+
+    // completing an unknown flight is a no-op
+    coalescer.complete("GET /api/v3/depth?symbol=BTCUSDT", nullptr, false);
+}
+
+TEST(RequestCoalescerTS, LeadTest)
+{
+    RequestCoalescer coalescer;
+    bool called(false);
+
+    EXPECT_TRUE(coalescer.lead("GET /api/v3/exchangeInfo"));
+    EXPECT_FALSE(coalescer.lead("GET /api/v3/exchangeInfo"));
+
+    // requests arriving meanwhile wait for the background fetch
+    EXPECT_FALSE(coalescer.join("GET /api/v3/exchangeInfo",
+                                [&called](SharedBufferChain, bool)
+                                {
+                                    called = true;
+                                }));
+
+    coalescer.complete("GET /api/v3/exchangeInfo", std::make_shared<BufferChain>(), true);
+    EXPECT_TRUE(called);
+    EXPECT_TRUE(coalescer.lead("GET /api/v3/exchangeInfo"));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "utils/response-cache.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    SharedBufferChain make_response(size_t size)
+    {
+        auto chain = std::make_shared<BufferChain>();
+        chain->append(std::string(size, '{').data(), size);
+        return chain;
+    }
+}
+
+TEST(ResponseCacheTS, TtlRulesTest)
+{
+    ResponseCache cache;
+
+    EXPECT_EQ(cache.policy("/api/v3/exchangeInfo").ttl, 60s);
+    EXPECT_EQ(cache.policy("/api/v3/ticker/price").ttl, 250ms);
+    EXPECT_EQ(cache.policy("/api/v3/ticker/24hr").ttl, 250ms);
+    EXPECT_EQ(cache.policy("/api/v3/depth").ttl, 0ms);
+    EXPECT_EQ(cache.policy("/api/v3/time").ttl, 0ms);
+
+    ResponseCache::Options options;
+    ResponseCache::add_rule(options.rules, {"/api/v3/ticker/24hr", {2s}});
+    ResponseCache::add_rule(options.rules, {"/api/v3/depth", {100ms}});
+    ResponseCache custom(options);
+
+    // the longest matching prefix wins
+    EXPECT_EQ(custom.policy("/api/v3/ticker/24hr").ttl, 2s);
+    EXPECT_EQ(custom.policy("/api/v3/ticker/price").ttl, 250ms);
+    EXPECT_EQ(custom.policy("/api/v3/depth").ttl, 100ms);
+}
+
+TEST(ResponseCacheTS, ParseRuleTest)
+{
+    auto rule = ResponseCache::parse_rule("/api/v3/klines=1500");
+    ASSERT_TRUE(rule);
+    EXPECT_EQ(rule->path_prefix, "/api/v3/klines");
+    EXPECT_EQ(rule->policy.ttl, 1500ms);
+    EXPECT_EQ(rule->policy.stale, 0ms);
+
+    rule = ResponseCache::parse_rule("/api/v3/exchangeInfo=60000:300000");
+    ASSERT_TRUE(rule);
+    EXPECT_EQ(rule->policy.ttl, 60s);
+    EXPECT_EQ(rule->policy.stale, 300s);
+
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines"));
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines="));
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines=1s"));
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines=-1"));
+    EXPECT_FALSE(ResponseCache::parse_rule("api/v3/klines=100"));
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines=100:"));
+    EXPECT_FALSE(ResponseCache::parse_rule("/api/v3/klines=100:x"));
+}
+
+TEST(ResponseCacheTS, ExpirationTest)
+{
+    ResponseCache cache;
+    const auto now = ResponseCache::Clock::now();
+
+    auto response = make_response(100);
+    cache.store("GET /api/v3/ticker/price", response, {250ms}, {}, now);
+    EXPECT_EQ(cache.find("GET /api/v3/ticker/price", now + 100ms).response, response);
+    EXPECT_EQ(cache.find("GET /api/v3/ticker/price", now + 250ms).response, nullptr);
+    EXPECT_EQ(cache.entries(), 0u);
+    EXPECT_EQ(cache.size(), 0u);
+
+    // a bypassed path is never stored
+    cache.store("GET /api/v3/depth", response, {0ms}, {}, now);
+    EXPECT_EQ(cache.find("GET /api/v3/depth", now).response, nullptr);
+}
+
+TEST(ResponseCacheTS, MemoryBudgetTest)
+{
+    ResponseCache::Options options;
+    options.max_size = 1000;
+    ResponseCache cache(options);
+    const auto now = ResponseCache::Clock::now();
+
+    cache.store("a", make_response(400), {1s}, {}, now);
+    cache.store("b", make_response(400), {1s}, {}, now);
+    EXPECT_NE(cache.find("a", now).response, nullptr); // "b" becomes the least recently used
+
+    cache.store("c", make_response(400), {1s}, {}, now);
+    EXPECT_EQ(cache.entries(), 2u);
+    EXPECT_EQ(cache.size(), 800u);
+    EXPECT_NE(cache.find("a", now).response, nullptr);
+    EXPECT_EQ(cache.find("b", now).response, nullptr);
+    EXPECT_NE(cache.find("c", now).response, nullptr);
+
+    // larger than the whole budget
+    cache.store("d", make_response(1001), {1s}, {}, now);
+    EXPECT_EQ(cache.find("d", now).response, nullptr);
+    EXPECT_EQ(cache.entries(), 2u);
+
+    // a replaced entry doesn't count twice
+    cache.store("c", make_response(100), {1s}, {}, now);
+    EXPECT_EQ(cache.size(), 500u);
+}
+
+TEST(ResponseCacheTS, DisabledTest)
+{
+    ResponseCache::Options options;
+    options.max_size = 0;
+    ResponseCache cache(options);
+
+    EXPECT_FALSE(cache.enabled());
+    cache.store("a", make_response(10), {1s});
+    EXPECT_EQ(cache.find("a").response, nullptr);
+}
+
+TEST(ResponseCacheTS, StaleWhileRevalidateTest)
+{
+    ResponseCache cache;
+    const auto now = ResponseCache::Clock::now();
+
+    auto response = make_response(100);
+    cache.store("GET /api/v3/exchangeInfo", response, {60s, 300s}, {}, now);
+
+    auto lookup = cache.find("GET /api/v3/exchangeInfo", now + 61s);
+    EXPECT_EQ(lookup.response, response);
+    EXPECT_EQ(lookup.freshness, ResponseCache::Freshness::Stale);
+
+    // a refreshed response replaces the stale one
+    auto refreshed = make_response(100);
+    cache.store("GET /api/v3/exchangeInfo", refreshed, {60s, 300s}, {}, now + 62s);
+    lookup = cache.find("GET /api/v3/exchangeInfo", now + 63s);
+    EXPECT_EQ(lookup.response, refreshed);
+    EXPECT_EQ(lookup.freshness, ResponseCache::Freshness::Fresh);
+
+    // past the stale window
+    EXPECT_EQ(cache.find("GET /api/v3/exchangeInfo", now + 62s + 360s).response, nullptr);
+}
+
+TEST(ResponseCacheTS, RefreshAheadTest)
+{
+    ResponseCache cache;
+    const auto now = ResponseCache::Clock::now();
+
+    // hit every 100 ms, a 1 s TTL, fetched in 50 ms: due 150 ms before the expiration
+    cache.store("hot", make_response(100), {1s}, 50ms, now);
+    for (auto at = 100ms; at <= 800ms; at += 100ms)
+        EXPECT_EQ(cache.find("hot", now + at).freshness, ResponseCache::Freshness::Fresh) << at.count();
+    EXPECT_EQ(cache.find("hot", now + 900ms).freshness, ResponseCache::Freshness::RefreshDue);
+
+    // a single hit per lifetime is not worth a refresh
+    cache.store("cold", make_response(100), {1s}, 50ms, now);
+    EXPECT_EQ(cache.find("cold", now + 990ms).freshness, ResponseCache::Freshness::Fresh);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "utils/session-registry.h"
+
+namespace
+{
+    struct TestSession : Session
+    {
+        explicit TestSession(uint64_t id) : id_(id) {}
+
+        void start() override {}
+        void stop() override { stopped_ = true; }
+        uint64_t get_id() override { return id_; }
+
+        SessionRegistry::Registration registration_;
+        uint64_t id_;
+        bool stopped_ = false;
+    };
+}
+
+TEST(SessionRegistryTS, RemovedOnDestructionTest)
+{
+    SessionRegistry registry;
+
+    auto first = std::make_shared<TestSession>(1);
+    auto second = std::make_shared<TestSession>(2);
+    first->registration_ = registry.add(first);
+    second->registration_ = registry.add(second);
+    EXPECT_EQ(registry.size(), 2u);
+
+    first.reset();
+    EXPECT_EQ(registry.size(), 1u);
+
+    std::set<uint64_t> listed;
+    registry.for_each([&listed](Session& session)
+                      { listed.insert(session.get_id()); });
+    EXPECT_EQ(listed, std::set<uint64_t>{2});
+
+    second.reset();
+    EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST(SessionRegistryTS, StopAllTest)
+{
+    SessionRegistry registry;
+    std::vector<std::shared_ptr<TestSession>> sessions;
+    for (uint64_t id = 1; id <= 40; id++)
+    {
+        sessions.push_back(std::make_shared<TestSession>(id));
+        sessions.back()->registration_ = registry.add(sessions.back());
+    }
+
+    // a session released while being stopped unregisters without deadlocking
+    registry.for_each([&sessions](Session& session)
+                      {
+                          session.stop();
+                          if (session.get_id() == 1)
+                              sessions.front().reset();
+                      });
+
+    EXPECT_EQ(registry.size(), 39u);
+    for (size_t i = 1; i < sessions.size(); i++)
+        EXPECT_TRUE(sessions[i]->stopped_);
+}
+
+TEST(SessionRegistryTS, ConcurrentChurnTest)
+{
+    SessionRegistry registry;
+    constexpr uint64_t threads = 4, per_thread = 2000;
+
+    std::vector<std::thread> workers;
+    for (uint64_t t = 0; t < threads; t++)
+        workers.emplace_back([&registry, t]()
+                             {
+                                 std::vector<std::shared_ptr<TestSession>> kept;
+                                 for (uint64_t i = 0; i < per_thread; i++)
+                                 {
+                                     auto session = std::make_shared<TestSession>(t * per_thread + i + 1);
+                                     session->registration_ = registry.add(session);
+                                     if (i % 100 == 0)
+                                         kept.push_back(std::move(session));
+                                 }
+                                 registry.for_each([](Session&) {});
+                                 kept.clear();
+                             });
+    for (auto& worker : workers)
+        worker.join();
+
+    EXPECT_EQ(registry.size(), 0u);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include "common/stats.h"
+#include "logs/logger.h"
+#include "upstream-resolver.h"
+
+namespace
+{
+    // resolutions completed by the test
+    class TestResolver : public UpstreamResolver
+    {
+    public:
+        using UpstreamResolver::on_resolved;
+        using UpstreamResolver::UpstreamResolver;
+    };
+
+    tcp::resolver::results_type results(const char* address)
+    {
+        return tcp::resolver::results_type::create(tcp::endpoint(asio::ip::make_address(address), 443),
+                                                   "api.binance.com", "443");
+    }
+}
+
+class UpstreamResolverTS : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!gl_logger)
+            gl_logger = std::make_shared<spdlog::logger>("g-tests", std::make_shared<spdlog::sinks::null_sink_mt>());
+    }
+
+    // the outcome of a resolve() call
+    struct Outcome
+    {
+        size_t calls = 0;
+        asio::error_code ec;
+        UpstreamResolver::Endpoints endpoints;
+    };
+
+    UpstreamResolver::ResolveHandler handler(Outcome& outcome)
+    {
+        return [&outcome](const asio::error_code& ec, UpstreamResolver::Endpoints endpoints)
+        {
+            outcome.calls++;
+            outcome.ec = ec;
+            outcome.endpoints = std::move(endpoints);
+        };
+    }
+
+    asio::io_context io_;
+};
+
+TEST_F(UpstreamResolverTS, CoalescedWaitersTest)
+{
+    UpstreamResolver resolver(io_, "localhost", "443", std::chrono::seconds(60));
+    const auto resolutions = gl_stats.dns_resolutions.load();
+
+    // nothing resolved yet, the waiters share a single resolution
+    Outcome outcomes[3];
+    for (auto& outcome : outcomes)
+        resolver.resolve(handler(outcome));
+    EXPECT_EQ(outcomes[0].calls, 0u);
+
+    io_.run();
+    EXPECT_EQ(gl_stats.dns_resolutions.load(), resolutions + 1);
+    for (const auto& outcome : outcomes)
+    {
+        EXPECT_EQ(outcome.calls, 1u);
+        ASSERT_FALSE(outcome.ec) << outcome.ec.message();
+        ASSERT_TRUE(outcome.endpoints);
+        EXPECT_FALSE(outcome.endpoints->empty());
+        EXPECT_EQ(outcome.endpoints.get(), outcomes[0].endpoints.get());
+    }
+
+    // served from the cache right away
+    Outcome cached;
+    resolver.resolve(handler(cached));
+    EXPECT_EQ(cached.calls, 1u);
+    EXPECT_EQ(cached.endpoints.get(), outcomes[0].endpoints.get());
+}
+
+TEST_F(UpstreamResolverTS, FailedRefreshTest)
+{
+    TestResolver resolver(io_, "api.binance.com", "443", std::chrono::seconds(60));
+    const auto failures = gl_stats.dns_failures.load();
+
+    resolver.on_resolved({}, results("10.0.0.1"));
+
+    // neither an error nor an empty resolution replaces the last known endpoints
+    resolver.on_resolved(asio::error::host_not_found_try_again, {});
+    resolver.on_resolved({}, {});
+    EXPECT_EQ(gl_stats.dns_failures.load(), failures + 2);
+
+    Outcome outcome;
+    resolver.resolve(handler(outcome));
+    EXPECT_EQ(outcome.calls, 1u);
+    EXPECT_FALSE(outcome.ec);
+    ASSERT_TRUE(outcome.endpoints);
+    ASSERT_EQ(outcome.endpoints->size(), 1u);
+    EXPECT_EQ(outcome.endpoints->front().address(), asio::ip::make_address("10.0.0.1"));
+
+    resolver.on_resolved({}, results("10.0.0.2"));
+    resolver.resolve(handler(outcome));
+    EXPECT_EQ(outcome.endpoints->front().address(), asio::ip::make_address("10.0.0.2"));
+}
+
+TEST_F(UpstreamResolverTS, EmptyResolutionTest)
+{
+    TestResolver resolver(io_, "api.binance.com", "443", std::chrono::seconds(60));
+    const auto failures = gl_stats.dns_failures.load();
+
+    // a success without any address fails the waiters
+    Outcome outcome;
+    resolver.resolve(handler(outcome));
+    resolver.on_resolved({}, {});
+
+    EXPECT_EQ(outcome.calls, 1u);
+    EXPECT_EQ(outcome.ec, asio::error::host_not_found);
+    EXPECT_FALSE(outcome.endpoints);
+    EXPECT_EQ(gl_stats.dns_failures.load(), failures + 1);
+}